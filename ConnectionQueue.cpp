@@ -0,0 +1,169 @@
+/**
+ * @file ConnectionQueue.cpp
+ *
+ */
+
+/*
+ * This file is part of eonsim.
+ *
+ * eonsim is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * eonsim is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with eonsim.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#include "ConnectionQueue.h"
+
+#include <algorithm>
+#include <iterator>
+
+namespace {
+/// The queue never shrinks below this number of buckets.
+const size_t minBuckets=16;
+/// The number of next expiries whose spacing determines the bucket width.
+const size_t widthSample=25;
+}
+
+ConnectionQueue::ConnectionQueue():
+	buckets(minBuckets),
+	mask(minBuckets-1),
+	width(1),
+	cur(0),
+	curEnd(1),
+	count(0),
+	nextSeq(0),
+	pool(),
+	freeSlots(),
+	topValid(false)
+{}
+
+/**
+ * Make the window that contains time t the current one.
+ */
+void ConnectionQueue::setWindow(simtime_t t) {
+	cur=(t/width)&mask;
+	curEnd=(t/width+1)*width;
+}
+
+ConnectionQueue::Handle ConnectionQueue::insert(simtime_t t, const Provisioning &p) {
+	Handle h;
+	if(freeSlots.empty()) {
+		h=pool.size();
+		pool.push_back(p);
+	} else {
+		h=freeSlots.back();
+		freeSlots.pop_back();
+		pool[h]=p;
+	}
+	const Entry e={t,nextSeq++,h};
+	if(t<curEnd-width) {
+		//earlier than the current window, start searching from there
+		setWindow(t);
+	}
+	Bucket &b=buckets[(t/width)&mask];
+	b.insert(std::lower_bound(b.begin(),b.end(),e,later),e);
+	topValid=false;
+	if(++count>2*buckets.size()) resize(2*buckets.size());
+	return h;
+}
+
+const ConnectionQueue::Entry &ConnectionQueue::top() {
+	if(!topValid) {
+		//visit the windows in turn until one has an entry
+		for(size_t i=0; i<buckets.size(); ++i) {
+			const Bucket &b=buckets[cur];
+			if(!b.empty() && b.back().time<curEnd) {
+				topValid=true;
+				return b.back();
+			}
+			cur=(cur+1)&mask;
+			curEnd+=width;
+		}
+		//all entries are more than a year of windows ahead, look at the first one directly
+		const Entry *first=nullptr;
+		for(const Bucket &b:buckets)
+			if(!b.empty() && (!first || later(*first,b.back()))) first=&b.back();
+		setWindow(first->time);
+		topValid=true;
+	}
+	return buckets[cur].back();
+}
+
+void ConnectionQueue::pop() {
+	top();
+	buckets[cur].pop_back();
+	topValid=false;
+	if(--count<buckets.size()/2 && buckets.size()>minBuckets) resize(buckets.size()/2);
+}
+
+void ConnectionQueue::release(Handle h) {
+	freeSlots.push_back(h);
+}
+
+void ConnectionQueue::clear() {
+	for(Bucket &b:buckets) b.clear();
+	count=0;
+	topValid=false;
+	freeSlots.clear();
+	for(Handle h=pool.size(); h>0; --h) freeSlots.push_back(h-1);
+}
+
+/**
+ * Redistribute the entries over a new number of buckets. The width is
+ * three times the average spacing of the next few expiries, so that most
+ * windows that are visited contain about one entry. Only the sample is
+ * sorted, so this takes linear time apart from sorting the (short) buckets.
+ */
+void ConnectionQueue::resize(size_t numBuckets) {
+	std::vector<Entry> all;
+	all.reserve(count);
+	for(Bucket &b:buckets) {
+		all.insert(all.end(),b.begin(),b.end());
+		Bucket().swap(b);
+	}
+	auto sampleEnd=all.begin()+std::min(widthSample,all.size());
+	std::partial_sort(all.begin(),sampleEnd,all.end(),
+			[](const Entry &a, const Entry &b){return later(b,a);});
+	if(sampleEnd-all.begin()>1)
+		width=std::max<simtime_t>(1,3*(std::prev(sampleEnd)->time-all.front().time)
+				/(sampleEnd-all.begin()-1));
+	buckets.resize(numBuckets);
+	mask=numBuckets-1;
+	for(const Entry &e:all)
+		buckets[(e.time/width)&mask].push_back(e);
+	for(Bucket &b:buckets)
+		std::sort(b.begin(),b.end(),later);
+	if(!all.empty()) setWindow(all.front().time);
+	topValid=false;
+}
+
+std::vector<const Provisioning*> ConnectionQueue::ordered() const {
+	std::vector<const Provisioning*> conns;
+	conns.reserve(count);
+	for(auto const &c:schedule()) conns.push_back(c.second);
+	return conns;
+}
+
+std::vector<ConnectionQueue::Entry> ConnectionQueue::entries() const {
+	std::vector<Entry> all;
+	all.reserve(count);
+	for(const Bucket &b:buckets) all.insert(all.end(),b.begin(),b.end());
+	std::sort(all.begin(),all.end(),[](const Entry &a, const Entry &b){return later(b,a);});
+	return all;
+}
+
+std::vector<std::pair<simtime_t, const Provisioning*> > ConnectionQueue::schedule() const {
+	const std::vector<Entry> all=entries();
+	std::vector<std::pair<simtime_t, const Provisioning*> > conns;
+	conns.reserve(all.size());
+	for(const Entry &e:all) conns.push_back(std::make_pair(e.time,&pool[e.conn]));
+	return conns;
+}
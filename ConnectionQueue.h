@@ -0,0 +1,109 @@
+/**
+ * @file ConnectionQueue.h
+ *
+ */
+
+/*
+ * This file is part of eonsim.
+ *
+ * eonsim is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * eonsim is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with eonsim.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#ifndef CONNECTIONQUEUE_H_
+#define CONNECTIONQUEUE_H_
+
+#include <stddef.h>
+#include <cstdint>
+#include <deque>
+#include <utility>
+#include <vector>
+
+#include "globaldef.h"
+#include "HugePages.h"
+#include "SimulationMsgs.h"
+
+/**
+ * \brief The active connections, ordered by the time at which they expire.
+ *
+ * The connections are stored in a pool and scheduled in a calendar queue
+ * (R. Brown, CACM 31(10), 1988): The time axis is divided into buckets of
+ * equal width that are reused cyclically, so inserting a connection and
+ * removing the next one to expire take constant time on average. The
+ * number of buckets follows the number of connections, and their width is
+ * adapted to the spacing of the next expiries whenever it changes.
+ *
+ * Connections that expire at the same time leave the queue in the order in
+ * which they were inserted.
+ *
+ * Pool slots are reused after release(), including the capacity of their
+ * paths, and a stored Provisioning keeps its address until it is released.
+ * A copy of the queue keeps the handles, so data structures that refer to
+ * connections by handle stay valid for the copy.
+ */
+class ConnectionQueue {
+public:
+	typedef uint32_t Handle;
+	struct Entry {
+		simtime_t time;
+		/// Insertion order, to break ties between equal expiry times.
+		uint64_t seq;
+		Handle conn;
+	};
+
+	ConnectionQueue();
+	/// Store a copy of p that expires at time t.
+	Handle insert(simtime_t t, const Provisioning &p);
+	bool empty() const {return count==0;}
+	size_t size() const {return count;}
+	/// The next connection to expire. The queue must not be empty.
+	const Entry &top();
+	/**
+	 * Remove the next connection from the queue. Its Provisioning stays
+	 * valid until it is released.
+	 */
+	void pop();
+	void release(Handle h);
+	const Provisioning &get(Handle h) const {return pool[h];}
+	void clear();
+	/// All connections in the order in which they expire.
+	std::vector<const Provisioning*> ordered() const;
+	/// The entries of all connections in the order in which they expire.
+	std::vector<Entry> entries() const;
+	/// All connections with their expiry times, in the order in which they expire.
+	std::vector<std::pair<simtime_t, const Provisioning*> > schedule() const;
+
+private:
+	typedef std::vector<Entry, HugePageAllocator<Entry> > Bucket;
+	/// Each bucket is sorted by descending (time, seq), so the next entry is at the back.
+	std::vector<Bucket> buckets;
+	size_t mask;
+	simtime_t width;
+	/// The bucket of the current window and the end of that window.
+	size_t cur;
+	simtime_t curEnd;
+	size_t count;
+	uint64_t nextSeq;
+	std::deque<Provisioning, HugePageAllocator<Provisioning> > pool;
+	std::vector<Handle> freeSlots;
+	/// True if the back of buckets[cur] is the next entry.
+	bool topValid;
+
+	static bool later(const Entry &a, const Entry &b) {
+		return a.time>b.time || (a.time==b.time && a.seq>b.seq);
+	}
+	void setWindow(simtime_t t);
+	void resize(size_t numBuckets);
+};
+
+#endif /* CONNECTIONQUEUE_H_ */
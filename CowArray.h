@@ -0,0 +1,115 @@
+/**
+ * @file CowArray.h
+ *
+ */
+
+/*
+ * This file is part of eonsim.
+ *
+ * eonsim is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * eonsim is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with eonsim.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#ifndef COWARRAY_H_
+#define COWARRAY_H_
+
+#include <stddef.h>
+#include <algorithm>
+#include <memory>
+#include <vector>
+
+#include "HugePages.h"
+
+/**
+ * \brief A paged array whose pages are shared between copies until they are written.
+ *
+ * Copying a CowArray only copies one pointer per page. A page is duplicated
+ * the first time it is accessed through mut() while another copy still
+ * refers to it. Reading through operator[] never copies.
+ *
+ * The reference counts are atomic, so copies of the same array can be used
+ * and modified by different threads, as long as each copy is only used by
+ * one thread at a time.
+ *
+ * All pages are allocated through HugePages.
+ */
+template<class T> class CowArray {
+public:
+	CowArray(size_t numPages, size_t pageSize):
+		pages(numPages),
+		pgSize(pageSize)
+	{
+		reset();
+	}
+
+	/// Read access to a page.
+	const T *operator[](size_t page) const {
+		return pages[page].get();
+	}
+
+	/// Write access to a page. Makes a private copy if the page is shared.
+	T *mut(size_t page) {
+		std::shared_ptr<T> &p=pages[page];
+		if(p.use_count()!=1) {
+			T *copy=static_cast<T*>(HugePages::allocate(pgSize*sizeof(T)));
+			std::uninitialized_copy(p.get(),p.get()+pgSize,copy);
+			p.reset(copy,Release(pgSize));
+		}
+		return p.get();
+	}
+
+	/**
+	 * Replace all pages by value-initialized ones.
+	 * Copies that still refer to the old pages are not affected.
+	 */
+	void reset() {
+		size_t n=pages.size()*pgSize;
+		T *mem=static_cast<T*>(HugePages::allocate(n*sizeof(T)));
+		std::uninitialized_fill_n(mem,n,T());
+		std::shared_ptr<T> slab(mem,Release(n));
+		for(size_t i=0; i<pages.size(); ++i)
+			pages[i]=std::shared_ptr<T>(slab.get()+i*pgSize,[slab](T*){});
+	}
+
+	size_t numPages() const {
+		return pages.size();
+	}
+
+	size_t pageSize() const {
+		return pgSize;
+	}
+
+	/**
+	 * The approximate memory of an array with the given dimensions after
+	 * reset(): the slab, plus one pointer and one reference count per page.
+	 */
+	static size_t memoryUsage(size_t numPages, size_t pageSize) {
+		return numPages*(pageSize*sizeof(T)+sizeof(std::shared_ptr<T>)+4*sizeof(void*));
+	}
+
+private:
+	/// Deleter for memory from HugePages that holds n objects.
+	struct Release {
+		size_t n;
+		explicit Release(size_t count): n(count) {}
+		void operator()(T *p) const {
+			for(size_t i=0; i<n; ++i) p[i].~T();
+			HugePages::deallocate(p,n*sizeof(T));
+		}
+	};
+
+	std::vector<std::shared_ptr<T> > pages;
+	size_t pgSize;
+};
+
+#endif /* COWARRAY_H_ */
@@ -0,0 +1,169 @@
+/**
+ * @file FailureAnalysis.cpp
+ *
+ */
+
+/*
+ * This file is part of eonsim.
+ *
+ * eonsim is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * eonsim is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with eonsim.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#include "FailureAnalysis.h"
+
+#include <boost/graph/compressed_sparse_row_graph.hpp>
+#include <algorithm>
+#include <stdexcept>
+
+template<specIndex_t numSlots>
+FailureAnalysis<numSlots>::FailureAnalysis(const NetworkGraph& topology):
+		numLinks(boost::num_edges(topology.g)),
+		priIndex(numLinks),
+		bkpIndex(numLinks),
+		once(numLinks),
+		twice(numLinks),
+		touched()
+{}
+
+template<specIndex_t numSlots>
+void FailureAnalysis<numSlots>::add(ConnectionQueue::Handle h, const Provisioning& p) {
+	for(auto const &e:p.priPath)
+		priIndex[e.idx].push_back(h);
+	for(auto const &e:p.bkpPath)
+		bkpIndex[e.idx].push_back(h);
+}
+
+/**
+ * Remove the connection with handle h and the paths of p from the index.
+ * Throws if it is not in the index, which means that the index and the
+ * active connections have diverged.
+ */
+template<specIndex_t numSlots>
+void FailureAnalysis<numSlots>::remove(ConnectionQueue::Handle h, const Provisioning& p) {
+	for(auto const &e:p.priPath) erase(priIndex[e.idx],h);
+	for(auto const &e:p.bkpPath) erase(bkpIndex[e.idx],h);
+}
+
+template<specIndex_t numSlots>
+void FailureAnalysis<numSlots>::erase(std::vector<ConnectionQueue::Handle> &v, ConnectionQueue::Handle h) {
+	auto it=std::find(v.begin(),v.end(),h);
+	if(it==v.end()) throw std::runtime_error("FailureAnalysis: connection is not in the index");
+	*it=v.back();
+	v.pop_back();
+}
+
+/**
+ * Replace the index by one for the given connections.
+ */
+template<specIndex_t numSlots>
+void FailureAnalysis<numSlots>::rebuild(const ConnectionQueue& conns) {
+	clear();
+	for(auto const &e:conns.entries())
+		add(e.conn,conns.get(e.conn));
+}
+
+template<specIndex_t numSlots>
+void FailureAnalysis<numSlots>::clear() {
+	for(auto &v:priIndex) v.clear();
+	for(auto &v:bkpIndex) v.clear();
+}
+
+/**
+ * The bytes held by the index, including unused capacity.
+ */
+template<specIndex_t numSlots>
+uint64_t FailureAnalysis<numSlots>::memoryUsage() const {
+	uint64_t bytes=(once.capacity()+twice.capacity())*sizeof(spectrum_bits)
+			+touched.capacity()*sizeof(size_t);
+	for(auto const &v:priIndex) bytes+=sizeof(v)+v.capacity()*sizeof(v[0]);
+	for(auto const &v:bkpIndex) bytes+=sizeof(v)+v.capacity()*sizeof(v[0]);
+	return bytes;
+}
+
+/**
+ * Fail each link in turn and count how many of the hit connections can be
+ * restored on their backup.
+ * The cost is proportional to the sum of the primary times backup path
+ * lengths over all active connections.
+ */
+template<specIndex_t numSlots>
+StatCounter::Survivability FailureAnalysis<numSlots>::analyze(const ConnectionQueue &conns) {
+	StatCounter::Survivability result;
+	for(linkIndex_t f=0; f<numLinks; ++f) {
+		const std::vector<ConnectionQueue::Handle> &hit=priIndex[f];
+		++result.failures;
+		result.unprotected+=bkpIndex[f].size();
+		if(hit.empty()) continue;
+
+		for(ConnectionQueue::Handle h:hit) {
+			const Provisioning &p=conns.get(h);
+			const spectrum_bits mask=bkpMask(p);
+			for(auto const &e:p.bkpPath) {
+				const size_t b=bkpFiber(p,e);
+				if(b>=once.size()) {
+					once.resize(b+1);
+					twice.resize(b+1);
+				}
+				if(once[b].none()) touched.push_back(b);
+				twice[b]|=once[b]&mask;
+				once[b]|=mask;
+			}
+		}
+		uint64_t restored=0, collided=0;
+		for(ConnectionQueue::Handle h:hit) {
+			const Provisioning &p=conns.get(h);
+			const spectrum_bits mask=bkpMask(p);
+			bool usable=true, collision=false;
+			for(auto const &e:p.bkpPath) {
+				if(e.idx==f) usable=false;
+				if((twice[bkpFiber(p,e)]&mask).any()) collision=true;
+			}
+			if(collision) ++collided;
+			else if(usable) ++restored;
+		}
+		for(size_t l:touched) {
+			once[l].reset();
+			twice[l].reset();
+		}
+		touched.clear();
+
+		result.affected+=hit.size();
+		result.restored+=restored;
+		result.collided+=collided;
+		result.worst=std::min(result.worst,(double)restored/hit.size());
+	}
+	return result;
+}
+
+template<specIndex_t numSlots>
+typename FailureAnalysis<numSlots>::spectrum_bits FailureAnalysis<numSlots>::bkpMask(
+		const Provisioning& p) {
+	spectrum_bits mask;
+	for(specIndex_t i=p.bkpSpecBegin; i<p.bkpSpecEnd; ++i)
+		mask[i]=true;
+	return mask;
+}
+
+/**
+ * The index of the fiber that carries the backup of p on link e in once and twice.
+ * Backups only collide if they use the same fiber.
+ */
+template<specIndex_t numSlots>
+size_t FailureAnalysis<numSlots>::bkpFiber(const Provisioning& p,
+		const NetworkGraph::Graph::edge_descriptor& e) const {
+	return (size_t)p.bkpFiber*numLinks+e.idx;
+}
+
+#define INSTANTIATE_FAILUREANALYSIS(n) template class FailureAnalysis<n>;
+FOR_EACH_NUM_SLOTS(INSTANTIATE_FAILUREANALYSIS)
@@ -0,0 +1,81 @@
+/**
+ * @file FailureAnalysis.h
+ *
+ */
+
+/*
+ * This file is part of eonsim.
+ *
+ * eonsim is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * eonsim is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with eonsim.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#ifndef FAILUREANALYSIS_H_
+#define FAILUREANALYSIS_H_
+
+#include <bitset>
+#include <map>
+#include <vector>
+
+#include "ConnectionQueue.h"
+#include "globaldef.h"
+#include "NetworkGraph.h"
+#include "SimulationMsgs.h"
+#include "StatCounter.h"
+
+/**
+ * \brief Evaluates all single link failures against the active connections.
+ *
+ * The analysis keeps a transposed index from each link to the connections
+ * that use it for their primary or backup path. This index is updated when
+ * connections are added or removed, so analyze() only has to look at the
+ * connections that are hit by each failure.
+ *
+ * For each failed link, the backup spectrum of all connections whose
+ * primary is hit is claimed on their backup links with bitset operations.
+ * A connection is restored if its backup does not use the failed link and
+ * its backup spectrum does not collide with that of another hit connection.
+ *
+ * The connections are referenced by their handle in the ConnectionQueue,
+ * not by address, so the index stays valid when the queue is copied (see
+ * Simulation::connections()).
+ */
+template<specIndex_t numSlots>
+class FailureAnalysis {
+public:
+	FailureAnalysis(const NetworkGraph &topology);
+	void add(ConnectionQueue::Handle h, const Provisioning &p);
+	void remove(ConnectionQueue::Handle h, const Provisioning &p);
+	void rebuild(const ConnectionQueue &conns);
+	void clear();
+	StatCounter::Survivability analyze(const ConnectionQueue &conns);
+	uint64_t memoryUsage() const;
+private:
+	typedef std::bitset<numSlots> spectrum_bits;
+	linkIndex_t numLinks;
+	/// The connections whose primary path uses each link.
+	std::vector<std::vector<ConnectionQueue::Handle> > priIndex;
+	/// The connections that have a backup reservation on each link.
+	std::vector<std::vector<ConnectionQueue::Handle> > bkpIndex;
+	/**
+	 * Backup spectrum claimed at least once and at least twice during one
+	 * failure, per fiber (see bkpFiber()). Grown on demand.
+	 */
+	std::vector<spectrum_bits> once, twice;
+	std::vector<size_t> touched;
+	size_t bkpFiber(const Provisioning &p, const NetworkGraph::Graph::edge_descriptor &e) const;
+	static spectrum_bits bkpMask(const Provisioning &p);
+	static void erase(std::vector<ConnectionQueue::Handle> &v, ConnectionQueue::Handle h);
+};
+
+#endif /* FAILUREANALYSIS_H_ */
@@ -0,0 +1,226 @@
+/**
+ * @file HugePages.cpp
+ *
+ */
+
+/*
+ * This file is part of eonsim.
+ *
+ * eonsim is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * eonsim is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with eonsim.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#include "HugePages.h"
+
+#include <sys/mman.h>
+#include <stdint.h>
+#include <algorithm>
+#include <atomic>
+#include <fstream>
+#include <iomanip>
+#include <sstream>
+
+#include "globaldef.h"
+
+namespace {
+
+HugePages::Mode mode=HugePages::OFF;
+
+std::atomic<size_t> mappedBytes(0), explicitBytes(0), advisedBytes(0),
+		plainBytes(0), numMappings(0), numFallbacks(0), poolBytes(0);
+size_t peakAnonKb=0, peakHugetlbKb=0;
+bool rollupReadable=false;
+
+/// Blocks up to this size are rounded to multiples of 16 bytes, larger ones to powers of two.
+const size_t linearLimit=1024;
+const size_t numLinearClasses=linearLimit/16;
+const size_t numClasses=numLinearClasses+20;
+
+struct FreeBlock {
+	FreeBlock *next;
+};
+
+/// Per thread pool state. Blocks freed by another thread simply join that thread's lists.
+thread_local FreeBlock *freeLists[numClasses];
+thread_local char *chunkPos=nullptr, *chunkEnd=nullptr;
+
+size_t sizeClass(size_t bytes, size_t &rounded) {
+	if(bytes<=linearLimit) {
+		rounded=bytes<16 ? 16 : (bytes+15)&~(size_t)15;
+		return rounded/16-1;
+	}
+	size_t c=numLinearClasses;
+	for(rounded=2*linearLimit; rounded<bytes; rounded*=2) ++c;
+	return c;
+}
+
+size_t roundToHugePages(size_t bytes) {
+	return (bytes+HUGEPAGE_SIZE-1)&~(HUGEPAGE_SIZE-1);
+}
+
+double mib(size_t bytes) {
+	return bytes/1048576.0;
+}
+
+/// Reads a field in kB from /proc/self/smaps_rollup. Returns false if it is not available.
+bool readRollup(const char *field, size_t &kb) {
+	std::ifstream f("/proc/self/smaps_rollup");
+	std::string line;
+	std::string prefix(field);
+	prefix+=':';
+	while(std::getline(f,line)) {
+		if(line.compare(0,prefix.size(),prefix)==0) {
+			std::istringstream(line.substr(prefix.size()))>>kb;
+			return true;
+		}
+	}
+	return false;
+}
+
+std::string thpSetting() {
+	std::ifstream f("/sys/kernel/mm/transparent_hugepage/enabled");
+	std::string s;
+	if(!std::getline(f,s)) return "unavailable";
+	return s;
+}
+
+}
+
+void HugePages::setMode(Mode m) {
+	mode=m;
+}
+
+HugePages::Mode HugePages::getMode() {
+	return mode;
+}
+
+bool HugePages::parseMode(const std::string& s, Mode& m) {
+	if(s=="off") m=OFF;
+	else if(s=="thp") m=TRANSPARENT;
+	else if(s=="explicit") m=EXPLICIT;
+	else return false;
+	return true;
+}
+
+void* HugePages::allocate(size_t bytes) {
+	if(mode==OFF) return ::operator new(bytes);
+	if(bytes<HUGEPAGE_MIN_BLOCK) return allocateSmall(bytes);
+	return map(roundToHugePages(bytes));
+}
+
+void HugePages::deallocate(void* p, size_t bytes) {
+	if(mode==OFF) ::operator delete(p);
+	else if(bytes<HUGEPAGE_MIN_BLOCK) deallocateSmall(p,bytes);
+	else unmap(p,roundToHugePages(bytes));
+}
+
+void* HugePages::map(size_t bytes) {
+	++numMappings;
+	mappedBytes+=bytes;
+#ifdef MAP_HUGETLB
+	if(mode==EXPLICIT) {
+		void *p=mmap(nullptr,bytes,PROT_READ|PROT_WRITE,
+				MAP_PRIVATE|MAP_ANONYMOUS|MAP_HUGETLB,-1,0);
+		if(p!=MAP_FAILED) {
+			explicitBytes+=bytes;
+			return p;
+		}
+		++numFallbacks;
+	}
+#endif
+	//over-allocate by one huge page and trim, so that the kernel can use huge pages for all of it
+	char *raw=static_cast<char*>(mmap(nullptr,bytes+HUGEPAGE_SIZE,PROT_READ|PROT_WRITE,
+			MAP_PRIVATE|MAP_ANONYMOUS,-1,0));
+	if(raw==MAP_FAILED) {
+		++numFallbacks;
+		mappedBytes-=bytes;
+		--numMappings;
+		throw std::bad_alloc();
+	}
+	char *p=reinterpret_cast<char*>(
+			(reinterpret_cast<uintptr_t>(raw)+HUGEPAGE_SIZE-1)&~(uintptr_t)(HUGEPAGE_SIZE-1));
+	if(p>raw) munmap(raw,p-raw);
+	munmap(p+bytes,raw+HUGEPAGE_SIZE-p);
+#ifdef MADV_HUGEPAGE
+	if(madvise(p,bytes,MADV_HUGEPAGE)==0) {
+		advisedBytes+=bytes;
+		return p;
+	}
+#endif
+	plainBytes+=bytes;
+	return p;
+}
+
+void HugePages::unmap(void* p, size_t bytes) {
+	munmap(p,bytes);
+}
+
+void* HugePages::allocateSmall(size_t bytes) {
+	size_t rounded;
+	size_t c=sizeClass(bytes,rounded);
+	if(freeLists[c]) {
+		FreeBlock *b=freeLists[c];
+		freeLists[c]=b->next;
+		return b;
+	}
+	if(chunkPos==nullptr || (size_t)(chunkEnd-chunkPos)<rounded) {
+		//the rest of the old chunk is given up, it is smaller than one block of this class
+		chunkPos=static_cast<char*>(map(HUGEPAGE_SIZE));
+		chunkEnd=chunkPos+HUGEPAGE_SIZE;
+		poolBytes+=HUGEPAGE_SIZE;
+	}
+	void *p=chunkPos;
+	chunkPos+=rounded;
+	return p;
+}
+
+void HugePages::deallocateSmall(void* p, size_t bytes) {
+	size_t rounded;
+	size_t c=sizeClass(bytes,rounded);
+	FreeBlock *b=static_cast<FreeBlock*>(p);
+	b->next=freeLists[c];
+	freeLists[c]=b;
+}
+
+void HugePages::sample() {
+	if(mode==OFF) return;
+	size_t anon=0, shared=0, priv=0;
+	if(!readRollup("AnonHugePages",anon)) return;
+	readRollup("Shared_Hugetlb",shared);
+	readRollup("Private_Hugetlb",priv);
+	rollupReadable=true;
+	peakAnonKb=std::max(peakAnonKb,anon);
+	peakHugetlbKb=std::max(peakHugetlbKb,shared+priv);
+}
+
+void HugePages::printReport(std::ostream& s) {
+	static const char *names[]={"off","thp","explicit"};
+	s<<"Huge pages: mode "<<names[mode]
+		<<", transparent huge pages "<<thpSetting()<<std::endl;
+	if(mode==OFF) return;
+	s<<std::fixed<<std::setprecision(1)
+		<<"  requested "<<mib(mappedBytes)<<" MiB in "<<numMappings<<" mappings ("
+		<<mib(poolBytes)<<" MiB pooled for small blocks): "
+		<<mib(explicitBytes)<<" MiB explicit, "
+		<<mib(advisedBytes)<<" MiB madvised, "
+		<<mib(plainBytes)<<" MiB plain, "
+		<<numFallbacks<<" fallbacks"<<std::endl;
+	sample();
+	if(rollupReadable) {
+		s<<"  achieved (whole process, peak of samples): "<<mib(peakAnonKb<<10)<<" MiB transparent, "
+			<<mib(peakHugetlbKb<<10)<<" MiB hugetlb"<<std::endl;
+	} else {
+		s<<"  achieved backing unknown, /proc/self/smaps_rollup is not readable"<<std::endl;
+	}
+	s<<std::defaultfloat;
+}
@@ -0,0 +1,114 @@
+/**
+ * @file HugePages.h
+ *
+ */
+
+/*
+ * This file is part of eonsim.
+ *
+ * eonsim is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * eonsim is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with eonsim.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#ifndef HUGEPAGES_H_
+#define HUGEPAGES_H_
+
+#include <stddef.h>
+#include <new>
+#include <ostream>
+#include <string>
+
+/**
+ * \brief Memory for the large simulation state, optionally backed by huge pages.
+ *
+ * The link state pages, the sharing matrix, the Dijkstra buffers and the
+ * active connection store are allocated here. With the mode OFF every
+ * request is forwarded to operator new. Otherwise blocks of at least
+ * HUGEPAGE_MIN_BLOCK bytes are mapped directly, rounded to whole huge
+ * pages, and smaller blocks are carved out of huge page sized chunks with
+ * one free list per size class and thread. Chunks are kept for reuse until
+ * the program exits.
+ *
+ * TRANSPARENT aligns the mappings to huge pages and marks them with
+ * madvise(MADV_HUGEPAGE). EXPLICIT maps them from the hugetlbfs pool with
+ * MAP_HUGETLB and falls back to TRANSPARENT for each mapping the pool
+ * cannot satisfy. Where neither is supported, plain pages are used.
+ *
+ * The mode has to be set before the first allocation and must not change
+ * afterwards.
+ */
+class HugePages {
+public:
+	enum Mode { OFF, TRANSPARENT, EXPLICIT };
+
+	static void setMode(Mode m);
+	static Mode getMode();
+	/// Parses "off", "thp" or "explicit". Returns false for anything else.
+	static bool parseMode(const std::string &s, Mode &m);
+
+	static void *allocate(size_t bytes);
+	/// bytes must be the value passed to the allocate() call that returned p.
+	static void deallocate(void *p, size_t bytes);
+
+	/**
+	 * Records how much memory the kernel currently backs by huge pages.
+	 * The achieved backing is only visible while the state is alive, so the
+	 * report uses the peak of all samples. Call from one thread only.
+	 */
+	static void sample();
+
+	/// Prints the page backing that was requested and achieved.
+	static void printReport(std::ostream &s);
+
+private:
+	HugePages();
+	static void *map(size_t bytes);
+	static void unmap(void *p, size_t bytes);
+	static void *allocateSmall(size_t bytes);
+	static void deallocateSmall(void *p, size_t bytes);
+};
+
+/**
+ * \brief STL allocator that takes its memory from HugePages.
+ */
+template<class T> class HugePageAllocator {
+public:
+	typedef T value_type;
+
+	HugePageAllocator() {}
+	template<class U> HugePageAllocator(const HugePageAllocator<U> &) {}
+
+	T *allocate(size_t n) {
+		return static_cast<T*>(HugePages::allocate(n*sizeof(T)));
+	}
+
+	void deallocate(T *p, size_t n) {
+		HugePages::deallocate(p,n*sizeof(T));
+	}
+
+	template<class U> struct rebind {
+		typedef HugePageAllocator<U> other;
+	};
+};
+
+template<class T, class U>
+bool operator==(const HugePageAllocator<T> &, const HugePageAllocator<U> &) {
+	return true;
+}
+
+template<class T, class U>
+bool operator!=(const HugePageAllocator<T> &, const HugePageAllocator<U> &) {
+	return false;
+}
+
+#endif /* HUGEPAGES_H_ */
@@ -0,0 +1,101 @@
+/**
+ * @file InvariantChecker.cpp
+ *
+ */
+
+/*
+ * This file is part of eonsim.
+ *
+ * eonsim is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * eonsim is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with eonsim.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#include "InvariantChecker.h"
+
+#include <boost/graph/compressed_sparse_row_graph.hpp>
+#include <boost/random/uniform_int_distribution.hpp>
+#include <algorithm>
+
+template<specIndex_t numSlots>
+InvariantChecker<numSlots>::InvariantChecker(const NetworkGraph& topology):
+		numLinks(boost::num_edges(topology.g)),
+		interval(0),
+		countdown(0),
+		budget(0.0),
+		batch(1),
+		numEvents(0),
+		spent(),
+		violation(false),
+		failedLink(0)
+{}
+
+/**
+ * Start checking for a new run.
+ * @param interval Check after every interval-th event; 0 disables the checker.
+ * @param budget The fraction of the run time that may be spent in checks.
+ */
+template<specIndex_t numSlots>
+void InvariantChecker<numSlots>::start(unsigned long interval, double budget) {
+	this->interval=interval;
+	this->budget=budget;
+	countdown=interval;
+	batch=1;
+	numEvents=0;
+	startTime=clock::now();
+	spent=clock::duration();
+	rng.seed(0);
+	violation=false;
+	failedLink=0;
+}
+
+/**
+ * Count an event that changed the NetworkState and check a batch of fibers
+ * if it is time to do so.
+ * @return false if a violation was found at this event. Nothing is checked
+ * after the first violation.
+ */
+template<specIndex_t numSlots>
+bool InvariantChecker<numSlots>::event(const NetworkState<numSlots>& s) {
+	if(!interval || violation) return true;
+	++numEvents;
+	if(--countdown) return true;
+	countdown=interval;
+
+	const clock::time_point begin=clock::now();
+	if(spent>(begin-startTime)*budget) return true;
+
+	//size_t, because first+i can exceed the range of linkIndex_t
+	const size_t total=(size_t)s.getNumFibers()*numLinks;
+	boost::random::uniform_int_distribution<size_t> startGen(0,total-1);
+	const size_t first=startGen(rng);
+	for(size_t i=0; i<batch; ++i) {
+		const linkIndex_t l=(first+i)%total;
+		if(!s.checkLink(l)) {
+			violation=true;
+			failedLink=l;
+			break;
+		}
+	}
+
+	//adapt the batch size to the remaining budget
+	const clock::time_point end=clock::now();
+	spent+=end-begin;
+	if(spent*2<(end-startTime)*budget)
+		batch=std::min<size_t>(batch*2,total);
+	else if(batch>1)
+		batch/=2;
+	return !violation;
+}
+
+#define INSTANTIATE_INVARIANTCHECKER(n) template class InvariantChecker<n>;
+FOR_EACH_NUM_SLOTS(INSTANTIATE_INVARIANTCHECKER)
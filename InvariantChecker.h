@@ -0,0 +1,73 @@
+/**
+ * @file InvariantChecker.h
+ *
+ */
+
+/*
+ * This file is part of eonsim.
+ *
+ * eonsim is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * eonsim is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with eonsim.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+
+#ifndef INVARIANTCHECKER_H_
+#define INVARIANTCHECKER_H_
+
+#include <boost/random/taus88.hpp>
+#include <chrono>
+#include <cstdint>
+
+#include "globaldef.h"
+#include "NetworkGraph.h"
+#include "NetworkState.h"
+
+/**
+ * \brief Sampled consistency check of a NetworkState that is cheap enough for real runs.
+ *
+ * Every interval events, a batch of fibers starting at a random position is
+ * checked with NetworkState::checkLink(), so all fibers are covered over
+ * time. The batch size adapts so that the time spent in the checks stays
+ * below the given fraction of the run time; checks are skipped while the
+ * budget is used up.
+ *
+ * The random positions come from a generator of their own, so enabling the
+ * checker does not change the simulation results.
+ */
+template<specIndex_t numSlots>
+class InvariantChecker {
+public:
+	InvariantChecker(const NetworkGraph &topology);
+	void start(unsigned long interval, double budget);
+	bool event(const NetworkState<numSlots> &s);
+	/// True once a violation has been found.
+	bool failed() const {return violation;}
+	/// The fiber that failed the check, see NetworkState::ReadSet for the numbering.
+	linkIndex_t getFailedLink() const {return failedLink;}
+	/// The number of events up to and including the one after which the violation was found.
+	uint64_t getFailedEvent() const {return numEvents;}
+private:
+	typedef std::chrono::steady_clock clock;
+	linkIndex_t numLinks;
+	unsigned long interval, countdown;
+	double budget;
+	size_t batch;
+	uint64_t numEvents;
+	clock::time_point startTime;
+	clock::duration spent;
+	boost::random::taus88 rng;
+	bool violation;
+	linkIndex_t failedLink;
+};
+
+#endif /* INVARIANTCHECKER_H_ */
@@ -27,6 +27,8 @@
 #include <cstdlib>
 #include <iostream>
 #include <iterator>
+#include <limits>
+#include <sstream>
 #include <stdexcept>
 
 JobIterator::JobIterator(const std::string &opts, const std::string &algs):
@@ -88,7 +90,11 @@ JobIterator::JobIterator(const std::string &opts, const std::string &algs):
 		++p1;
 	}
 
+	checkNumSlots(globalopts);
+	checkNumFibers(globalopts);
 	for(auto a=algopts.rbegin(); a!=algopts.rend(); ++a) {
+		checkNumSlots(a->second);
+		checkNumFibers(a->second);
 		currentParams=a->second;
 		currentParams.insert(globalopts.begin(),globalopts.end());
 		size_t algIterations=1;
@@ -197,3 +203,42 @@ const char * JobIterator::parseOpts(const char *begin, const char *end, optmap_t
 	}
 	return 0; //unreachable, but makes eclipse's static analyzer happy.
 }
+
+/**
+ * Make sure that all values of the "slots" parameter are supported.
+ * Only the slot counts in FOR_EACH_NUM_SLOTS are compiled into the program.
+ */
+void JobIterator::checkNumSlots(const optmap_t &optmap) const {
+	auto it=optmap.find("slots");
+	if(it==optmap.end()) return;
+	const paramRange_t &r=it->second;
+	for(int i=0; r.min+i*r.step<=r.max; ++i) {
+		double n=r.min+i*r.step;
+#define IS_NUM_SLOTS(s) if(n==s) continue;
+		FOR_EACH_NUM_SLOTS(IS_NUM_SLOTS)
+#undef IS_NUM_SLOTS
+#define LIST_NUM_SLOTS(s) " " #s
+		std::ostringstream msg;
+		msg<<"Unsupported number of slots: "<<n
+			<<". Supported values are:" FOR_EACH_NUM_SLOTS(LIST_NUM_SLOTS);
+		throw std::runtime_error(msg.str());
+#undef LIST_NUM_SLOTS
+	}
+}
+
+/**
+ * Make sure that all values of the "fibers" parameter are usable numbers of
+ * fibers per link.
+ */
+void JobIterator::checkNumFibers(const optmap_t &optmap) const {
+	auto it=optmap.find("fibers");
+	if(it==optmap.end()) return;
+	const paramRange_t &r=it->second;
+	for(int i=0; r.min+i*r.step<=r.max; ++i) {
+		double n=r.min+i*r.step;
+		if(n>=1 && n==floor(n) && n<=std::numeric_limits<fiberIndex_t>::max()) continue;
+		std::ostringstream msg;
+		msg<<"Unsupported number of fibers: "<<n<<". It must be a positive integer.";
+		throw std::runtime_error(msg.str());
+	}
+}
@@ -50,7 +50,9 @@ public:
 	typedef struct{
 		size_t index;
 		std::string algname;
-		ProvisioningScheme::ParameterSet params;
+		ProvisioningSchemeBase::ParameterSet params;
+		/// The replication of the job, see the "reps" parameter. Always 0 here.
+		unsigned int replication;
 	} job_t;
 	job_t operator*() const;
 private:
@@ -69,6 +71,8 @@ private:
 	std::vector<std::pair<std::string, optmap_t> >::const_iterator currentAlg;
 	optmap_t currentParams;
 	const char * parseOpts(const char *begin, const char *end, optmap_t &optmap) const;
+	void checkNumSlots(const optmap_t &optmap) const;
+	void checkNumFibers(const optmap_t &optmap) const;
 	size_t totalIterations, currentIteration;
 
 };
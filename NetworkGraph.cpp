@@ -33,6 +33,8 @@
 #include <limits>
 #include <map>
 
+#include "PhaseTimer.h"
+
 using namespace boost;
 
 NetworkGraph::NetworkGraph(edgeIterator edge_begin, edgeIterator edge_end,
@@ -90,24 +92,61 @@ void NetworkGraph::printAsDot(std::ostream& s) const {
 	s<<"}\n";
 }
 
+/**
+ * The average number of links on a minimum hop path, over all ordered
+ * pairs of different nodes that are connected.
+ */
+double NetworkGraph::averageHopCount() const {
+	const size_t numNodes=num_vertices(g), unreached=std::numeric_limits<size_t>::max();
+	std::vector<size_t> hops(numNodes), queue;
+	uint64_t sum=0, pairs=0;
+	for(size_t s=0; s<numNodes; ++s) {
+		std::fill(hops.begin(),hops.end(),unreached);
+		hops[s]=0;
+		queue.assign(1,s);
+		for(size_t i=0; i<queue.size(); ++i) {
+			auto oe=out_edges(vertex(queue[i],g),g);
+			for(auto e=oe.first; e!=oe.second; ++e) {
+				size_t t=target(*e,g);
+				if(hops[t]!=unreached) continue;
+				hops[t]=hops[queue[i]]+1;
+				sum+=hops[t];
+				++pairs;
+				queue.push_back(t);
+			}
+		}
+	}
+	return pairs?(double)sum/pairs:0.0;
+}
+
 NetworkGraph::DijkstraData::DijkstraData(const NetworkGraph &g):
-		weights(new distance_t[num_edges(g.g)]),
-		tmpWeights(new distance_t[num_edges(g.g)]),
-		dists(new distance_t[num_vertices(g.g)]),
-		preds(new Graph::vertex_descriptor[num_vertices(g.g)]),
-		colors(new unsigned char[num_vertices(g.g)]),
+		weights(alloc<distance_t>(num_edges(g.g))),
+		tmpWeights(alloc<distance_t>(num_edges(g.g))),
+		dists(alloc<distance_t>(num_vertices(g.g))),
+		preds(alloc<Graph::vertex_descriptor>(num_vertices(g.g))),
+		colors(alloc<unsigned char>(num_vertices(g.g))),
+		pathCache(nullptr),
 		link_lengths(g.link_lengths),
-		wSize(num_edges(g.g)*sizeof(distance_t))
+		wSize(num_edges(g.g)*sizeof(distance_t)),
+		numVertices(num_vertices(g.g))
 {
 	resetWeights();
 }
 
 NetworkGraph::DijkstraData::~DijkstraData() {
-	delete[] colors;
-	delete[] preds;
-	delete[] dists;
-	delete[] tmpWeights;
-	delete[] weights;
+	HugePages::deallocate(colors,numVertices*sizeof(unsigned char));
+	HugePages::deallocate(preds,numVertices*sizeof(Graph::vertex_descriptor));
+	HugePages::deallocate(dists,numVertices*sizeof(distance_t));
+	HugePages::deallocate(tmpWeights,wSize);
+	HugePages::deallocate(weights,wSize);
+}
+
+/**
+ * The bytes of the buffers of a DijkstraData object for a graph of the given size.
+ */
+size_t NetworkGraph::DijkstraData::memoryUsage(size_t numEdges, size_t numVertices) {
+	return 2*numEdges*sizeof(distance_t)
+			+numVertices*(sizeof(distance_t)+sizeof(Graph::vertex_descriptor)+sizeof(unsigned char));
 }
 
 void NetworkGraph::DijkstraData::resetWeights() const {
@@ -115,9 +154,17 @@ void NetworkGraph::DijkstraData::resetWeights() const {
 	memcpy(tmpWeights,link_lengths,wSize);
 }
 
+/**
+ * True if the weights are the link lengths, i.e. no links are excluded.
+ */
+bool NetworkGraph::DijkstraData::hasOriginalWeights() const {
+	return memcmp(weights,link_lengths,wSize)==0;
+}
+
 NetworkGraph::Path NetworkGraph::dijkstra(
 		Graph::vertex_descriptor s, Graph::vertex_descriptor d,
 		const DijkstraData& data) const {
+	PHASE_SCOPE(PATHS);
 	boost::dijkstra_shortest_paths(
 			g,
 			s,
@@ -154,11 +201,23 @@ NetworkGraph::YenKShortestSearch::YenKShortestSearch(const NetworkGraph& g,
 				d(d),
 				data(data),
 				A(),
-				B()
+				B(),
+				trie()
 {
 }
 
 std::vector<NetworkGraph::Path> &NetworkGraph::YenKShortestSearch::getPaths(unsigned int k) {
+	PHASE_SCOPE(PATHS);
+	if(k<=A.size()) return A;
+	if(!data.pathCache || !A.empty() || !data.hasOriginalWeights()) return search(k);
+	if(!data.pathCache->restore(*this,k)) {
+		search(k);
+		data.pathCache->store(*this,k);
+	}
+	return A;
+}
+
+std::vector<NetworkGraph::Path> &NetworkGraph::YenKShortestSearch::search(unsigned int k) {
 	if(k<=A.size()) return A;
 	if(!A.size()) {
 		const Path p=g.dijkstra(s,d,data);
@@ -238,9 +297,22 @@ std::vector<NetworkGraph::Path> &NetworkGraph::YenKShortestSearch::getPaths(unsi
 	return A;
 }
 
+/**
+ * Get the same paths as getPaths(k), as a prefix tree.
+ * The i-th path in getPaths() ends at trie node leaves[i].
+ */
+const NetworkGraph::PathTrie &NetworkGraph::YenKShortestSearch::getTrie(unsigned int k) {
+	PHASE_SCOPE(PATHS);
+	getPaths(k);
+	for(size_t i=trie.leaves.size(); i<A.size(); ++i)
+		trie.insert(A[i]);
+	return trie;
+}
+
 void NetworkGraph::YenKShortestSearch::reset() {
 	A.clear();
 	B.clear();
+	trie.clear();
 }
 
 void NetworkGraph::YenKShortestSearch::reset(Graph::vertex_descriptor s, Graph::vertex_descriptor d) {
@@ -249,6 +321,72 @@ void NetworkGraph::YenKShortestSearch::reset(Graph::vertex_descriptor s, Graph::
 	this->d=d;
 }
 
+NetworkGraph::PathCache::PathCache():
+		s(),
+		d(),
+		entries()
+{}
+
+void NetworkGraph::PathCache::clear() {
+	entries.clear();
+}
+
+/**
+ * Take over the stored state of a search for the same nodes and k.
+ * @return false if there is none.
+ */
+bool NetworkGraph::PathCache::restore(YenKShortestSearch &y, unsigned int k) const {
+	if(y.s!=s || y.d!=d) return false;
+	auto it=entries.find(k);
+	if(it==entries.end()) return false;
+	y.A=it->second.A;
+	y.B=it->second.B;
+	y.trie=it->second.trie;
+	return true;
+}
+
+void NetworkGraph::PathCache::store(const YenKShortestSearch &y, unsigned int k) {
+	if(y.s!=s || y.d!=d) {
+		entries.clear();
+		s=y.s;
+		d=y.d;
+	}
+	Entry &e=entries[k];
+	e.A=y.A;
+	e.B=y.B;
+	e.trie=y.trie;
+}
+
+const size_t NetworkGraph::PathTrie::none;
+
+NetworkGraph::PathTrie::PathTrie():
+		nodes(),
+		leaves()
+{
+	clear();
+}
+
+void NetworkGraph::PathTrie::insert(const Path& p) {
+	size_t n=0;
+	for(auto const &e:p) {
+		size_t c=nodes[n].firstChild;
+		while(c!=none && nodes[c].edge.idx!=e.idx)
+			c=nodes[c].nextSibling;
+		if(c==none) {
+			c=nodes.size();
+			nodes.push_back(Node({e,n,none,nodes[n].firstChild}));
+			nodes[n].firstChild=c;
+		}
+		n=c;
+	}
+	leaves.push_back(n);
+}
+
+void NetworkGraph::PathTrie::clear() {
+	nodes.assign(1,Node({Graph::edge_descriptor(),none,none,none}));
+	leaves.clear();
+}
+
 std::ostream & operator<<(std::ostream &os, const NetworkGraph::Path& p) {
 	for(auto const &e:p) os<<e.src<<'-';
 	return os;
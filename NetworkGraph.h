@@ -33,6 +33,7 @@
 #include <vector>
 
 #include "globaldef.h"
+#include "HugePages.h"
 
 /**
  * \brief Holds the network graph structure and supports path search.
@@ -56,6 +57,7 @@ public:
 			linkIndex_t  //edge index type
 			> Graph;
 	Graph g;
+	class PathCache;
 	/**
 	 * \brief Distance and predecessor matrices used by the Dijkstra algorithm.
 	 *
@@ -70,15 +72,49 @@ public:
 		Graph::vertex_descriptor *const preds;
 		unsigned char *const colors;
 		void resetWeights() const;
+		bool hasOriginalWeights() const;
+		static size_t memoryUsage(size_t numEdges, size_t numVertices);
+		/// If not null, k-shortest path searches on the original weights are shared through this cache.
+		mutable PathCache *pathCache;
 	private:
 		const distance_t *const link_lengths;
-		size_t wSize;
+		size_t wSize, numVertices;
 		DijkstraData(const DijkstraData &);
+		/// The buffers are plain arrays of trivial types, so they are used without construction.
+		template<class T> static T *alloc(size_t n) {
+			return static_cast<T*>(HugePages::allocate(n*sizeof(T)));
+		}
 	};
 
 	typedef std::vector<Graph::edge_descriptor> Path;
 
+	/**
+	 * \brief A set of paths from the same source, stored as a prefix tree.
+	 *
+	 * Paths that start with the same edges share the nodes of their common
+	 * prefix. A node's parent always has a smaller index than the node, so
+	 * a forward pass over the nodes visits every prefix before its
+	 * extensions.
+	 */
+	class PathTrie {
+	public:
+		/// A trie node represents the path from the root along its parents up to and including edge.
+		struct Node {
+			Graph::edge_descriptor edge;
+			size_t parent, firstChild, nextSibling;
+		};
+		static const size_t none=~(size_t)0;
+		PathTrie();
+		void insert(const Path &p);
+		void clear();
+		/// nodes[0] is the root, i.e. the empty path.
+		std::vector<Node> nodes;
+		/// leaves[i] is the node at the end of the i-th inserted path.
+		std::vector<size_t> leaves;
+	};
+
 	void printAsDot(std::ostream &s) const;
+	double averageHopCount() const;
 	Path dijkstra(Graph::vertex_descriptor s, Graph::vertex_descriptor d, const DijkstraData &data) const;
 
 	/**
@@ -88,9 +124,11 @@ public:
 	public:
 		YenKShortestSearch(const NetworkGraph &g, Graph::vertex_descriptor s, Graph::vertex_descriptor d, const DijkstraData &data);
 		std::vector<Path> &getPaths(unsigned int k);
+		const PathTrie &getTrie(unsigned int k);
 		void reset();
 		void reset(Graph::vertex_descriptor s, Graph::vertex_descriptor d);
 	private:
+		friend class PathCache;
 		typedef std::vector<Graph::vertex_descriptor> VertexPath;
 		typedef std::multimap<distance_t,VertexPath> yen_path_buffer;
 
@@ -99,6 +137,34 @@ public:
 		const DijkstraData &data;
 		std::vector<Path> A;
 		yen_path_buffer B;
+		PathTrie trie;
+		std::vector<Path> &search(unsigned int k);
+	};
+
+	/**
+	 * \brief The k-shortest path searches of one source and destination.
+	 *
+	 * Holds the state of a YenKShortestSearch after getPaths(k) for each k
+	 * that was asked for, as long as the search started on the original
+	 * link lengths. A search with the same s, d and k then takes over that
+	 * state instead of computing it. Only the last pair of nodes is kept,
+	 * which suits several algorithms that handle the same request in turn.
+	 */
+	class PathCache {
+	public:
+		PathCache();
+		void clear();
+	private:
+		friend class YenKShortestSearch;
+		struct Entry {
+			std::vector<Path> A;
+			YenKShortestSearch::yen_path_buffer B;
+			PathTrie trie;
+		};
+		Graph::vertex_descriptor s, d;
+		std::map<unsigned int,Entry> entries;
+		bool restore(YenKShortestSearch &y, unsigned int k) const;
+		void store(const YenKShortestSearch &y, unsigned int k);
 	};
 private:
 	typedef std::vector<std::pair<nodeIndex_t, nodeIndex_t> >::iterator edgeIterator;
@@ -26,66 +26,86 @@
 #include "NetworkState.h"
 
 #include <assert.h>
+#include <algorithm>
 #include <boost/graph/compressed_sparse_row_graph.hpp>
 #include <boost/graph/graph_traits.hpp>
+#include <cmath>
 #include <iterator>
+#include <limits>
+#include <stdexcept>
 #include <vector>
 
 #include "NetworkGraph.h"
-#include "Simulation.h"
+#include "PhaseTimer.h"
 
-NetworkState::NetworkState(const NetworkGraph& topology) :
+template<specIndex_t numSlots>
+NetworkState<numSlots>::NetworkState(const NetworkGraph& topology, fiberIndex_t numFibers) :
 numLinks(boost::num_edges(topology.g)),
 numNodes(boost::num_vertices(topology.g)),
+numFibers(numFibers),
 numAmps(),
-primaryUse(new spectrum_bits[numLinks]),
-anyUse(new spectrum_bits[numLinks]),
-sharing(new spectrum_bits[numLinks*numLinks]),
-currentPriSlots(0),
-currentBkpSlots(0),
-currentBkpLpSlots(0),
-currentTxSlots(),
-frag(new linkfrag_t[numLinks]),
-linkAmps(new unsigned short[numLinks])
+links(numFibers*numLinks,1),
+sharing(numFibers*numLinks,numLinks),
+nodeFree(numFibers*numNodes,numSlots+1),
+linkSource(numLinks),
+linkAmps(numLinks),
+inTransaction(false),
+linkVersion(numFibers*numLinks),
+nodeVersion(numFibers*numNodes),
+lastVersion(0),
+freedBkp(numFibers*numLinks),
+termFlags(numFibers*numLinks),
+touched(),
+rebuild()
 {
+	if(numFibers*numLinks>std::numeric_limits<linkIndex_t>::max())
+		throw std::runtime_error("NetworkState: too many fibers for linkIndex_t");
 	for(linkIndex_t i=0; i<numLinks; ++i) {
 		linkAmps[i]=lrint(ceil(topology.link_lengths[i]*DISTANCE_UNIT/AMP_DIST)+1);
 		numAmps+=linkAmps[i];
 	}
+	auto edges=boost::edges(topology.g);
+	for(auto e=edges.first; e!=edges.second; ++e)
+		linkSource[e->idx]=boost::source(*e,topology.g);
+	resetCounters();
+	resetNodeFree();
 }
 
-NetworkState::~NetworkState() {
-	delete[] sharing;
-	delete[] anyUse;
-	delete[] primaryUse;
+template<specIndex_t numSlots>
+NetworkState<numSlots>::~NetworkState() {
 }
 
-void NetworkState::provision(const Provisioning &p) {
+template<specIndex_t numSlots>
+void NetworkState<numSlots>::provision(const Provisioning &p) {
+	PHASE_SCOPE(STATE);
 	for(const auto &e:p.priPath) {
+		LinkState &l=writeLink(fiberLink(e.idx,p.priFiber));
 		for(specIndex_t i=p.priSpecBegin;i<p.priSpecEnd;++i) {
 #ifndef NDEBUG
-			assert(!primaryUse[e.idx][i]);
-			assert(!anyUse[e.idx][i]);
+			assert(!l.primaryUse[i]);
+			assert(!l.anyUse[i]);
 #endif
-			primaryUse[e.idx][i]=true;
-			anyUse[e.idx][i]=true;
+			l.primaryUse[i]=true;
+			l.anyUse[i]=true;
 		}
-		if(frag[e.idx].priEnd<p.priSpecEnd)
-			frag[e.idx].priEnd=p.priSpecEnd;
+		if(l.frag.priEnd<p.priSpecEnd)
+			l.frag.priEnd=p.priSpecEnd;
 	}
 	for(const auto &eb:p.bkpPath) {
+		const linkIndex_t b=fiberLink(eb.idx,p.bkpFiber);
+		LinkState &l=writeLink(b);
 		for(specIndex_t i=p.bkpSpecBegin;i<p.bkpSpecEnd;++i)
-			if(!anyUse[eb.idx][i]) {
-				++currentBkpSlots;
-				anyUse[eb.idx][i]=true;
+			if(!l.anyUse[i]) {
+				++current.bkpSlots;
+				l.anyUse[i]=true;
 			}
-		if(frag[eb.idx].bkpBegin>p.bkpSpecBegin)
-			frag[eb.idx].bkpBegin=p.bkpSpecBegin;
+		if(l.frag.bkpBegin>p.bkpSpecBegin)
+			l.frag.bkpBegin=p.bkpSpecBegin;
 		for(const auto &ep:p.priPath) {
 #ifndef NDEBUG
 			assert(eb.idx!=ep.idx);
 #endif
-			auto &s=sharing[eb.idx*numLinks+ep.idx];
+			auto &s=writeSharing(b,ep.idx);
 			for(specIndex_t i=p.bkpSpecBegin;i<p.bkpSpecEnd;++i) {
 #ifndef NDEBUG
 				if(s[i]) {
@@ -99,268 +119,847 @@ void NetworkState::provision(const Provisioning &p) {
 		}
 	}
 
-	updateLinkFrag(p.priPath);
-	updateLinkFrag(p.bkpPath);
-	currentBkpLpSlots+=(p.bkpSpecEnd-p.bkpSpecBegin)*p.bkpPath.size();
-	currentPriSlots+=(p.priSpecEnd-p.priSpecBegin)*p.priPath.size();
-	currentTxSlots[p.priMod]+=p.priSpecEnd-p.priSpecBegin;
+	for(const auto &e:p.priPath) updateLinkFrag(fiberLink(e.idx,p.priFiber));
+	for(const auto &e:p.bkpPath) updateLinkFrag(fiberLink(e.idx,p.bkpFiber));
+	for(const auto &e:p.priPath) accountLinkMetrics(fiberLink(e.idx,p.priFiber));
+	for(const auto &e:p.bkpPath) accountLinkMetrics(fiberLink(e.idx,p.bkpFiber));
+	current.bkpLpSlots+=(p.bkpSpecEnd-p.bkpSpecBegin)*p.bkpPath.size();
+	current.priSlots+=(p.priSpecEnd-p.priSpecBegin)*p.priPath.size();
+	current.txSlots[p.priMod]+=p.priSpecEnd-p.priSpecBegin;
 }
 
-void NetworkState::terminate(const Provisioning &p) {
-	for(const auto &e:p.priPath) {
-		for(specIndex_t i=p.priSpecBegin;i<p.priSpecEnd;++i) {
-			primaryUse[e.idx][i]=false;
-			anyUse[e.idx][i]=false;
+template<specIndex_t numSlots>
+void NetworkState<numSlots>::terminate(const Provisioning &p) {
+	const Provisioning *const one=&p;
+	terminate(&one,&one+1);
+}
+
+/**
+ * Remove several connections at once.
+ * The result is the same as terminating them one by one, but each backup
+ * link that is shared by several of them only has its backup spectrum
+ * rebuilt once, and the fragmentation of each link is only updated once.
+ */
+template<specIndex_t numSlots>
+void NetworkState<numSlots>::terminate(const std::vector<const Provisioning*> &batch) {
+	terminate(batch.data(),batch.data()+batch.size());
+}
+
+/**
+ * Remove the connections in [begin,end), see terminate(const std::vector<const Provisioning*>&).
+ * Uses the scratch vectors of the NetworkState, so it does not allocate
+ * once they have grown to the largest batch.
+ */
+template<specIndex_t numSlots>
+void NetworkState<numSlots>::terminate(const Provisioning *const *begin, const Provisioning *const *end) {
+	PHASE_SCOPE(STATE);
+	touched.clear();
+	rebuild.clear();
+	for(const Provisioning *const *it=begin; it!=end; ++it) {
+		const Provisioning *p=*it;
+		for(const auto &e:p->priPath) {
+			const linkIndex_t pl=fiberLink(e.idx,p->priFiber);
+			LinkState &l=writeLink(pl);
+			for(specIndex_t i=p->priSpecBegin;i<p->priSpecEnd;++i) {
+				l.primaryUse[i]=false;
+				l.anyUse[i]=false;
+			}
+			if(l.frag.priEnd==p->priSpecEnd) {
+				l.frag.priEnd=0;
+				for(specIndex_t i=0; i<p->priSpecEnd; ++i)
+					if(l.primaryUse[i]) l.frag.priEnd=i;
+			}
+			if(!termFlags[pl]) touched.push_back(pl);
+			termFlags[pl]|=TERM_TOUCHED;
 		}
-		if(frag[e.idx].priEnd==p.priSpecEnd) {
-			frag[e.idx].priEnd=0;
-			for(specIndex_t i=0; i<p.priSpecEnd; ++i)
-				if(primaryUse[e.idx][i]) frag[e.idx].priEnd=i;
+		//the primary links now do not share any backup here any more
+		for(const auto &eb:p->bkpPath)
+			for(const auto &ep:p->priPath) {
+				spectrum_bits &s=writeSharing(fiberLink(eb.idx,p->bkpFiber),ep.idx);
+				for(specIndex_t i=p->bkpSpecBegin;i<p->bkpSpecEnd;++i)
+					s[i]=false;
+			}
+		//remember which backup spectrum was freed on which link
+		for(const auto &eb:p->bkpPath) {
+			const linkIndex_t b=fiberLink(eb.idx,p->bkpFiber);
+			if(!termFlags[b]) touched.push_back(b);
+			if(!(termFlags[b]&TERM_BKP)) {
+				rebuild.push_back(b);
+				freedBkp[b].reset();
+			}
+			termFlags[b]|=TERM_TOUCHED|TERM_BKP;
+			for(specIndex_t i=p->bkpSpecBegin;i<p->bkpSpecEnd;++i)
+				freedBkp[b][i]=true;
+			if(links[b]->frag.bkpBegin==p->bkpSpecBegin)
+				termFlags[b]|=TERM_BKP_BEGIN;
 		}
+		current.bkpLpSlots-=(p->bkpSpecEnd-p->bkpSpecBegin)*p->bkpPath.size();
+		current.priSlots-=(p->priSpecEnd-p->priSpecBegin)*p->priPath.size();
+		current.txSlots[p->priMod]-=p->priSpecEnd-p->priSpecBegin;
 	}
-	//the primary links now do not share any backup here any more
-	for(const auto &eb:p.bkpPath)
-		for(const auto &ep:p.priPath)
-			for(specIndex_t i=p.bkpSpecBegin;i<p.bkpSpecEnd;++i)
-				sharing[eb.idx*numLinks+ep.idx][i]=false;
 
 	/* On each previous backup link, construct the new backup spectrum
 	 * by checking all other links' sharing entries.
 	 * Takes a huge O(bkpLen*numLinks*numSlots).
 	 * This is a possible downside of the sharing matrix implementation.
 	 */
-	for(const auto &eb:p.bkpPath) {
-		anyUse[eb.idx]=primaryUse[eb.idx];
-		spectrum_bits * const shb=sharing+eb.idx*numLinks;
+	for(const linkIndex_t b:rebuild) {
+		LinkState &l=writeLink(b);
+		l.anyUse=l.primaryUse;
+		const spectrum_bits * const shb=sharing[b];
 		spectrum_bits bkpUse=shb[0];
 		for(linkIndex_t i=1; i<numLinks; ++i)
 			bkpUse|=shb[i];
-		anyUse[eb.idx]|=bkpUse;
+		l.anyUse|=bkpUse;
 
 		//account for the freed slots
-		for(specIndex_t i=p.bkpSpecBegin; i<p.bkpSpecEnd; ++i)
-			if(!bkpUse[i]) --currentBkpSlots;
+		current.bkpSlots-=(freedBkp[b]&~bkpUse).count();
 
 		//if the beginning of the backup spectrum has moved, find the new
 		//position.
-		if(frag[eb.idx].bkpBegin==p.bkpSpecBegin) {
-			frag[eb.idx].bkpBegin=NUM_SLOTS;
-			for(specIndex_t i=NUM_SLOTS; i>=p.bkpSpecBegin && i<=NUM_SLOTS; --i)
-				if(bkpUse[i]) frag[eb.idx].bkpBegin=i;
+		if(termFlags[b]&TERM_BKP_BEGIN) {
+			specIndex_t i=l.frag.bkpBegin;
+			while(i<numSlots && !bkpUse[i]) ++i;
+			l.frag.bkpBegin=i;
 		}
 	}
 
-	updateLinkFrag(p.priPath);
-	updateLinkFrag(p.bkpPath);
-	currentBkpLpSlots-=(p.bkpSpecEnd-p.bkpSpecBegin)*p.bkpPath.size();
-	currentPriSlots-=(p.priSpecEnd-p.priSpecBegin)*p.priPath.size();
-	currentTxSlots[p.priMod]-=p.priSpecEnd-p.priSpecBegin;
+	for(const linkIndex_t l:touched) updateLinkFrag(l);
+	for(const linkIndex_t l:touched) accountLinkMetrics(l);
+	for(const linkIndex_t l:touched)
+		termFlags[l]=0;
 }
 
-NetworkState::spectrum_bits NetworkState::priAvailability(
-		const NetworkGraph::Path& priPath) const {
+template<specIndex_t numSlots>
+fiberIndex_t NetworkState<numSlots>::getNumFibers() const {
+	return numFibers;
+}
+
+/**
+ * The lowest slot at which width consecutive slots are free, or numSlots if
+ * there is none.
+ * Works on whole bitsets: After the loop, bit i of free is set iff all the
+ * slots [i,i+width) are free.
+ */
+template<specIndex_t numSlots>
+specIndex_t NetworkState<numSlots>::firstFit(const spectrum_bits &used, specIndex_t width) {
+	if(!width || width>numSlots) return numSlots;
+	spectrum_bits free=~used;
+	for(specIndex_t len=1; len<width && free.any(); ) {
+		const specIndex_t step=std::min<specIndex_t>(len,width-len);
+		free&=free>>step;
+		len+=step;
+	}
+	for(specIndex_t i=0; i+width<=numSlots; ++i)
+		if(free[i]) return i;
+	return numSlots;
+}
+
+template<specIndex_t numSlots>
+typename NetworkState<numSlots>::spectrum_bits NetworkState<numSlots>::priAvailability(
+		const NetworkGraph::Path& priPath, fiberIndex_t fiber) const {
+	PHASE_SCOPE(SPECTRUM);
 	typedef NetworkGraph::Path::const_iterator edgeIt;
 	spectrum_bits result;
 	for(edgeIt it=priPath.begin(); it!=priPath.end(); ++it)
-		result|=anyUse[it->idx];
+		result|=readLink(fiberLink(it->idx,fiber)).anyUse;
 	return result;
 }
 
-NetworkState::spectrum_bits NetworkState::bkpAvailability(
+template<specIndex_t numSlots>
+typename NetworkState<numSlots>::spectrum_bits NetworkState<numSlots>::bkpAvailability(
 		const NetworkGraph::Path &priPath,
-		const NetworkGraph::Graph::edge_descriptor bkpLink) const {
+		const NetworkGraph::Graph::edge_descriptor bkpLink,
+		fiberIndex_t fiber) const {
 	typedef NetworkGraph::Path::const_iterator edgeIt;
-	spectrum_bits result=primaryUse[bkpLink.idx];
+	const linkIndex_t b=fiberLink(bkpLink.idx,fiber);
+	//the sharing row is covered by the link's version
+	spectrum_bits result=readLink(b).primaryUse;
+	const spectrum_bits * const shb=sharing[b];
 	for(edgeIt it=priPath.begin(); it!=priPath.end(); ++it)
-		result|=sharing[bkpLink.idx*numLinks+it->idx];
+		result|=shb[it->idx];
 	return result;
 }
 
-NetworkState::spectrum_bits NetworkState::bkpAvailability(
+template<specIndex_t numSlots>
+typename NetworkState<numSlots>::spectrum_bits NetworkState<numSlots>::bkpAvailability(
 		const NetworkGraph::Path& priPath,
-		const NetworkGraph::Path& bkpPath) const {
+		const NetworkGraph::Path& bkpPath,
+		fiberIndex_t fiber) const {
+	PHASE_SCOPE(SPECTRUM);
 	typedef NetworkGraph::Path::const_iterator edgeIt;
 	spectrum_bits result;
 	for(edgeIt itb=bkpPath.begin(); itb!=bkpPath.end(); ++itb) {
-		result|=primaryUse[itb->idx];
+		const linkIndex_t b=fiberLink(itb->idx,fiber);
+		result|=readLink(b).primaryUse;
+		const spectrum_bits * const shb=sharing[b];
 		for(edgeIt itp=priPath.begin(); itp!=priPath.end(); ++itp)
-			result|=sharing[itb->idx*numLinks+itp->idx];
+			result|=shb[itp->idx];
 	}
 	return result;
 }
 
-void NetworkState::reset() {
-	for(size_t i=0; i<numLinks; ++i) primaryUse[i].reset();
-	for(size_t i=0; i<numLinks; ++i) anyUse[i].reset();
-	for(size_t i=0; i<static_cast<size_t>(numLinks*numLinks); ++i) sharing[i].reset();
-	currentPriSlots=0;
-	currentBkpSlots=0;
-	currentBkpLpSlots=0;
-	for(size_t i=0; i<sizeof(currentTxSlots)/sizeof(currentTxSlots[0]); ++i) currentTxSlots[i]=0;
-	for(size_t i=0; i<numLinks; ++i) frag[i]=LinkFrag();
+template<specIndex_t numSlots>
+void NetworkState<numSlots>::reset() {
+	links.reset();
+	sharing.reset();
+	nodeFree.reset();
+	inTransaction=false;
+	linkUndo.clear();
+	sharingUndo.clear();
+	resetCounters();
+	resetNodeFree();
+	++lastVersion;
+	std::fill(linkVersion.begin(),linkVersion.end(),lastVersion);
+	std::fill(nodeVersion.begin(),nodeVersion.end(),lastVersion);
+}
+
+/**
+ * The memory of a freshly reset NetworkState for a network of the given size.
+ * Sets the NetworkState fields of m.
+ */
+template<specIndex_t numSlots>
+void NetworkState<numSlots>::estimateMemory(linkIndex_t numLinks, nodeIndex_t numNodes,
+		fiberIndex_t numFibers, StatCounter::Memory& m) {
+	const size_t fiberLinks=(size_t)numFibers*numLinks, fiberNodes=(size_t)numFibers*numNodes;
+	m.linkState=CowArray<LinkState>::memoryUsage(fiberLinks,1);
+	m.sharing=CowArray<spectrum_bits>::memoryUsage(fiberLinks,numLinks);
+	m.nodeFree=CowArray<unsigned int>::memoryUsage(fiberNodes,numSlots+1);
+	m.stateOther=sizeof(NetworkState)
+			+numLinks*(sizeof(nodeIndex_t)+sizeof(unsigned short))
+			+fiberLinks*(sizeof(uint64_t)+sizeof(spectrum_bits)+sizeof(unsigned char))
+			+fiberNodes*sizeof(uint64_t);
+}
+
+/**
+ * The memory that this NetworkState currently holds, including the
+ * capacity of its undo logs. Sets the NetworkState fields of m.
+ */
+template<specIndex_t numSlots>
+void NetworkState<numSlots>::countMemory(StatCounter::Memory& m) const {
+	estimateMemory(numLinks,numNodes,numFibers,m);
+	m.stateOther+=linkUndo.capacity()*sizeof(linkUndo[0])
+			+sharingUndo.capacity()*sizeof(SharingUndo);
 }
 
 #ifndef NDEBUG
-void NetworkState::sanityCheck(
-		const std::multimap<unsigned long, Provisioning>& conns) const {
+template<specIndex_t numSlots>
+void NetworkState<numSlots>::sanityCheck(
+		const ConnectionQueue& conns) const {
 	unsigned int totalHops=0;
-	for(auto const &c:conns) {
-		totalHops+=c.second.priPath.size();
-		for(auto const &ep:c.second.priPath) {
-			for(specIndex_t i=c.second.priSpecBegin; i<c.second.priSpecEnd; ++i) {
-				assert(primaryUse[ep.idx][i]);
-				assert(anyUse[ep.idx][i]);
+	for(auto const c:conns.ordered()) {
+		totalHops+=c->priPath.size();
+		for(auto const &ep:c->priPath) {
+			const linkIndex_t p=fiberLink(ep.idx,c->priFiber);
+			for(specIndex_t i=c->priSpecBegin; i<c->priSpecEnd; ++i) {
+				assert(links[p]->primaryUse[i]);
+				assert(links[p]->anyUse[i]);
 			}
 		}
-		for(auto const &eb:c.second.bkpPath) {
-			for(specIndex_t i=c.second.bkpSpecBegin; i<c.second.bkpSpecEnd; ++i) {
-				assert(!primaryUse[eb.idx][i]);
-				assert(anyUse[eb.idx][i]);
+		for(auto const &eb:c->bkpPath) {
+			const linkIndex_t b=fiberLink(eb.idx,c->bkpFiber);
+			for(specIndex_t i=c->bkpSpecBegin; i<c->bkpSpecEnd; ++i) {
+				assert(!links[b]->primaryUse[i]);
+				assert(links[b]->anyUse[i]);
 			}
-			for(auto const &ep:c.second.priPath) {
-				for(specIndex_t i=c.second.bkpSpecBegin; i<c.second.bkpSpecEnd; ++i) {
-					assert(sharing[eb.idx*numLinks+ep.idx][i]);
+			for(auto const &ep:c->priPath) {
+				for(specIndex_t i=c->bkpSpecBegin; i<c->bkpSpecEnd; ++i) {
+					assert(sharing[b][ep.idx][i]);
 				}
 			}
 		}
 	}
-	for(linkIndex_t b=0; b<numLinks; ++b) {
-		spectrum_bits anyUseTest=primaryUse[b];
-		spectrum_bits * const shb=sharing+b*numLinks;
+	for(linkIndex_t b=0; b<numFibers*numLinks; ++b) {
+		spectrum_bits anyUseTest=links[b]->primaryUse;
+		const spectrum_bits * const shb=sharing[b];
 		for(linkIndex_t p=0; p<numLinks; ++p)
 			anyUseTest|=shb[p];
-		assert(anyUse[b]==anyUseTest);
+		assert(links[b]->anyUse==anyUseTest);
 	}
+	std::vector<unsigned int> nodeFreeTest(numFibers*numNodes*(numSlots+1));
+	for(linkIndex_t l=0; l<numFibers*numLinks; ++l)
+		for(specIndex_t i=0; i<numSlots; ++i)
+			if(!links[l]->anyUse[i])
+				for(specIndex_t j=i+1; j<=numSlots; ++j)
+					++nodeFreeTest[fiberNode(l)*(numSlots+1)+j];
+	for(nodeIndex_t n=0; n<numFibers*numNodes; ++n)
+		assert(std::equal(nodeFree[n],nodeFree[n]+numSlots+1,&nodeFreeTest[n*(numSlots+1)]));
 }
 #endif
 
-unsigned int NetworkState::calcCuts(const NetworkGraph& g,
+/**
+ * Check the invariants of a single fiber (see ReadSet for the numbering):
+ * anyUse must be the union of primaryUse and the fiber's sharing row,
+ * bkpBegin must be the first backup slot, priFrag, bkpFrag and totalFrag
+ * must match a recalculation from anyUse, priEnd and bkpBegin, and the
+ * values that are included in the running totals (accountedUse and
+ * accountedFrag) must be the current ones. priEnd itself is not checked,
+ * because terminating the topmost primary may leave it above the last
+ * primary slot.
+ * Unlike sanityCheck(), this is available in all builds and only costs
+ * O(numLinks) bitset operations plus one updateLinkFrag(), so it can be
+ * used for sampled checks.
+ * @return false if the fiber's state is inconsistent.
+ */
+template<specIndex_t numSlots>
+bool NetworkState<numSlots>::checkLink(linkIndex_t l) const {
+	const LinkState &ls=*links[l];
+	const spectrum_bits * const shb=sharing[l];
+	spectrum_bits bkpUse;
+	for(linkIndex_t p=0; p<numLinks; ++p)
+		bkpUse|=shb[p];
+	if(ls.anyUse!=(ls.primaryUse|bkpUse)) return false;
+	if(ls.accountedUse!=ls.anyUse) return false;
+	specIndex_t bkpBegin=0;
+	while(bkpBegin<numSlots && !bkpUse[bkpBegin]) ++bkpBegin;
+	if(ls.frag.bkpBegin!=bkpBegin) return false;
+	linkfrag_t f=ls.frag;
+	calcLinkFrag(ls.anyUse,f);
+	if(f.priFrag!=ls.frag.priFrag || f.bkpFrag!=ls.frag.bkpFrag
+			|| f.totalFrag!=ls.frag.totalFrag) return false;
+	const linkfrag_t &a=ls.accountedFrag;
+	return a.priEnd==f.priEnd && a.bkpBegin==f.bkpBegin && a.priFrag==f.priFrag
+			&& a.bkpFrag==f.bkpFrag && a.totalFrag==f.totalFrag;
+}
+
+template<specIndex_t numSlots>
+unsigned int NetworkState<numSlots>::calcCuts(const NetworkGraph& g,
 		const NetworkGraph::Path& p,
-		const specIndex_t begin, const specIndex_t end) const {
-	if(begin==0 || end==NUM_SLOTS) return 0;
+		const specIndex_t begin, const specIndex_t end, fiberIndex_t fiber) const {
+	if(begin==0 || end==numSlots) return 0;
 	unsigned int result=0;
-	for(auto const &e:p)
-		if(!anyUse[e.idx][begin-1] && !anyUse[e.idx][end])
+	for(auto const &e:p) {
+		const spectrum_bits &u=readLink(fiberLink(e.idx,fiber)).anyUse;
+		if(!u[begin-1] && !u[end])
 			++result;
+	}
 	return result;
 }
 
-double NetworkState::calcMisalignments(const NetworkGraph& g,
+template<specIndex_t numSlots>
+double NetworkState<numSlots>::calcMisalignments(const NetworkGraph& g,
 		const NetworkGraph::Path& p,
-		const specIndex_t begin, const specIndex_t end) const {
+		const specIndex_t begin, const specIndex_t end, fiberIndex_t fiber) const {
 	double result=0.0;
-	typedef boost::graph_traits <NetworkGraph::Graph>::out_edge_iterator out_edge_iterator;
+	//selects the slots [begin,end)
+	const spectrum_bits window=(~spectrum_bits()>>(numSlots-(end-begin)))<<begin;
 	for(auto const &e:p) {
-		std::pair<out_edge_iterator, out_edge_iterator> outEdges =
-				boost::out_edges(e.src, g.g);
-		unsigned int numFreeSlots=0, numAdjLinks=boost::out_degree(e.src,g.g);
-		for(; outEdges.first != outEdges.second; ++outEdges.first)
-			if(outEdges.first.dereference().idx!=e.idx)
-				for(specIndex_t i=begin; i<end; ++i)
-					if(!anyUse[outEdges.first.dereference().idx][i])
-						++numFreeSlots;
-		result+=(double)numFreeSlots/(double)numAdjLinks;
+		//free slots on all adjacent links, minus the ones on the path's own link
+		const linkIndex_t l=fiberLink(e.idx,fiber);
+		const unsigned int * const nf=readNodeFree(fiberNode(l));
+		unsigned int numFreeSlots=nf[end]-nf[begin]
+				-(end-begin)+(readLink(l).anyUse&window).count();
+		result+=(double)numFreeSlots/(double)boost::out_degree(e.src,g.g);
 	}
 
 	return result;
 }
 
-unsigned int NetworkState::countFreeBlocks(const NetworkGraph::Path& bkpPath,
-		specIndex_t i) const {
+template<specIndex_t numSlots>
+unsigned int NetworkState<numSlots>::countFreeBlocks(const NetworkGraph::Path& bkpPath,
+		specIndex_t i, fiberIndex_t fiber) const {
 	specIndex_t result=0;
 	for(auto const &e:bkpPath)
-		if(!anyUse[e.idx][i]) ++result;
+		if(!readLink(fiberLink(e.idx,fiber)).anyUse[i]) ++result;
 	return result;
 }
 
-unsigned int NetworkState::countFreeBlocks(const NetworkGraph::Path& p,
-		const specIndex_t begin, const specIndex_t end) const {
+template<specIndex_t numSlots>
+unsigned int NetworkState<numSlots>::countFreeBlocks(const NetworkGraph::Path& p,
+		const specIndex_t begin, const specIndex_t end, fiberIndex_t fiber) const {
 	unsigned int result=0;
-	for(auto const &e:p)
+	for(auto const &e:p) {
+		const spectrum_bits &u=readLink(fiberLink(e.idx,fiber)).anyUse;
 		for(specIndex_t i=begin; i<end; ++i)
-			if(!anyUse[e.idx][i]) ++result;
+			if(!u[i]) ++result;
+	}
 	return result;
 }
 
-StatCounter::PerfMetrics NetworkState::getCurrentPerfMetrics() const {
-	StatCounter::PerfMetrics p;
-	p.utilization=(double)(currentPriSlots+currentBkpSlots);///(double)(numLinks*NUM_SLOTS);
-	p.sharability=(double)currentBkpLpSlots/(double)currentBkpSlots;
-	p.numLinks=numLinks;
-	unsigned long idleAmps=0;
-	for(linkIndex_t i=0; i<numLinks; ++i) {
-		p.addLink(frag[i].bkpBegin,frag[i].bkpFrag,
-				frag[i].priEnd,frag[i].priFrag,
-				frag[i].totalFrag);
-		if(frag[i].priEnd==0 && frag[i].bkpBegin==NUM_SLOTS)
-			idleAmps+=linkAmps[i];
+/**
+ * Build the table in one pass over the path's links: the free slots of each
+ * link are added to bit-sliced counters with whole-bitset operations, so the
+ * per-slot work is only done once at the end.
+ */
+template<specIndex_t numSlots>
+typename NetworkState<numSlots>::free_blocks_t NetworkState<numSlots>::freeBlockTable(
+		const NetworkGraph::Path& p, fiberIndex_t fiber) const {
+	PHASE_SCOPE(COST);
+	//bit i of planes[k] is bit k of the number of free links in slot i
+	spectrum_bits planes[std::numeric_limits<linkIndex_t>::digits];
+	unsigned int numPlanes=0;
+	for(auto const &e:p) {
+		spectrum_bits carry=~readLink(fiberLink(e.idx,fiber)).anyUse;
+		unsigned int k=0;
+		for(; carry.any(); ++k) {
+			const spectrum_bits c=planes[k]&carry;
+			planes[k]^=carry;
+			carry=c;
+		}
+		if(numPlanes<k) numPlanes=k;
+	}
+	free_blocks_t result;
+	result[0]=0;
+	for(specIndex_t i=0; i<numSlots; ++i) {
+		unsigned int n=0;
+		for(unsigned int k=0; k<numPlanes; ++k)
+			n|=planes[k][i]<<k;
+		result[i+1]=result[i]+n;
 	}
-	p.e_stat=(numLinks/2)*85.0 + numNodes*150.0	+(numAmps/2)*140.0;
-	p.e_dyn+=(numAmps-idleAmps)*30.0;
-	p.e_dyn=fma((double)currentTxSlots[BPSK] , 47.13,p.e_dyn);
-	p.e_dyn=fma((double)currentTxSlots[QPSK] , 62.75,p.e_dyn);
-	p.e_dyn=fma((double)currentTxSlots[QAM8] , 78.38,p.e_dyn);
-	p.e_dyn=fma((double)currentTxSlots[QAM16], 94.00,p.e_dyn);
-	p.e_dyn=fma((double)currentTxSlots[QAM32],109.63,p.e_dyn);
-	p.e_dyn=fma((double)currentTxSlots[QAM64],125.23,p.e_dyn);
+	return result;
+}
+
+template<specIndex_t numSlots>
+StatCounter::PerfMetrics NetworkState<numSlots>::getCurrentPerfMetrics() const {
+	StatCounter::PerfMetrics p;
+	p.utilization=(double)(current.priSlots+current.bkpSlots);///(double)(numLinks*numSlots);
+	p.sharability=(double)current.bkpLpSlots/(double)current.bkpSlots;
+	p.numLinks=numFibers*numLinks;
+	p.numSlots=numSlots;
+	p.priEnd=current.priEnd;
+	p.bkpBegin=current.bkpBegin;
+	p.priFrag=(double)current.priFrag/FRAG_SCALE;
+	p.bkpFrag=(double)current.bkpFrag/FRAG_SCALE;
+	p.totalFrag=(double)current.totalFrag/FRAG_SCALE;
+	p.collisions=current.collisions;
+	p.e_stat=(numFibers*numLinks/2)*85.0 + numNodes*150.0	+(numFibers*numAmps/2)*140.0;
+	p.e_dyn+=(numFibers*numAmps-current.idleAmps)*30.0;
+	p.e_dyn=fma((double)current.txSlots[BPSK] , 47.13,p.e_dyn);
+	p.e_dyn=fma((double)current.txSlots[QPSK] , 62.75,p.e_dyn);
+	p.e_dyn=fma((double)current.txSlots[QAM8] , 78.38,p.e_dyn);
+	p.e_dyn=fma((double)current.txSlots[QAM16], 94.00,p.e_dyn);
+	p.e_dyn=fma((double)current.txSlots[QAM32],109.63,p.e_dyn);
+	p.e_dyn=fma((double)current.txSlots[QAM64],125.23,p.e_dyn);
 	return p;
 }
 
-NetworkState::LinkFrag::LinkFrag():
+/**
+ * The fraction of used slots on the fullest link (fiber).
+ */
+template<specIndex_t numSlots>
+double NetworkState<numSlots>::getMaxUtilization() const {
+	size_t used=0;
+	for(linkIndex_t l=0; l<numFibers*numLinks; ++l)
+		used=std::max(used,links[l]->anyUse.count());
+	return (double)used/numSlots;
+}
+
+template<specIndex_t numSlots>
+NetworkState<numSlots>::LinkFrag::LinkFrag():
 	priEnd(0),
-	bkpBegin(NUM_SLOTS),
+	bkpBegin(numSlots),
 	priFrag(0.0),
 	bkpFrag(0.0),
 	totalFrag(0.0)
 {}
 
-void NetworkState::updateLinkFrag(const NetworkGraph::Path& p) {
-	for(const auto &e:p) {
-		specIndex_t longestFree=0, totalLongestFree=0;
-		specIndex_t sectionTotalFree=0, totalFree=0;
-		specIndex_t c=0;
-		for(specIndex_t i=0; i<frag[e.idx].priEnd; ++i) {
-			if(!anyUse[e.idx][i]) {
-				++c;
-			}else if(c) {
-				if(c>longestFree) {
-					longestFree=c;
-				}
-				sectionTotalFree+=c;
-				c=0;
+/**
+ * Recalculate the fragmentation values for a fiber, see fiberLink().
+ * The fiber must already have been recorded with writeLink().
+ */
+template<specIndex_t numSlots>
+void NetworkState<numSlots>::updateLinkFrag(linkIndex_t fl) {
+	LinkState &l=*links.mut(fl);
+	calcLinkFrag(l.anyUse,l.frag);
+}
+
+/**
+ * Calculate priFrag, bkpFrag and totalFrag of f from the spectrum usage of
+ * a fiber and the priEnd and bkpBegin in f.
+ */
+template<specIndex_t numSlots>
+void NetworkState<numSlots>::calcLinkFrag(const spectrum_bits &anyUse, linkfrag_t &f) {
+	specIndex_t longestFree=0, totalLongestFree=0;
+	specIndex_t sectionTotalFree=0, totalFree=0;
+	specIndex_t c=0;
+	for(specIndex_t i=0; i<f.priEnd; ++i) {
+		if(!anyUse[i]) {
+			++c;
+		}else if(c) {
+			if(c>longestFree) {
+				longestFree=c;
 			}
+			sectionTotalFree+=c;
+			c=0;
 		}
-		frag[e.idx].priFrag=sectionTotalFree?
-				1.0-(double)longestFree/(double)sectionTotalFree : 0.0;
-		totalFree=sectionTotalFree;
-		totalLongestFree=longestFree;
-
-		specIndex_t mid=0;
-		if(frag[e.idx].bkpBegin>frag[e.idx].priEnd) {
-			mid=frag[e.idx].bkpBegin-frag[e.idx].priEnd;
-			totalFree+=mid;
-			if(mid>totalLongestFree) totalLongestFree=mid;
-		}
-		c=0;
-		longestFree=0;
-		sectionTotalFree=0;
-		for(specIndex_t i=frag[e.idx].bkpBegin; i<NUM_SLOTS; ++i) {
-			if(!anyUse[e.idx][i]) {
-				++c;
-			}else if(c) {
-				if(c>longestFree) {
-					if(c>totalLongestFree) totalLongestFree=c;
-					longestFree=c;
-				}
-				sectionTotalFree+=c;
-				if(i>frag[e.idx].priEnd) totalFree+=c;
-				c=0;
+	}
+	f.priFrag=sectionTotalFree?
+			1.0-(double)longestFree/(double)sectionTotalFree : 0.0;
+	totalFree=sectionTotalFree;
+	totalLongestFree=longestFree;
+
+	specIndex_t mid=0;
+	if(f.bkpBegin>f.priEnd) {
+		mid=f.bkpBegin-f.priEnd;
+		totalFree+=mid;
+		if(mid>totalLongestFree) totalLongestFree=mid;
+	}
+	c=0;
+	longestFree=0;
+	sectionTotalFree=0;
+	for(specIndex_t i=f.bkpBegin; i<numSlots; ++i) {
+		if(!anyUse[i]) {
+			++c;
+		}else if(c) {
+			if(c>longestFree) {
+				if(c>totalLongestFree) totalLongestFree=c;
+				longestFree=c;
 			}
+			sectionTotalFree+=c;
+			if(i>f.priEnd) totalFree+=c;
+			c=0;
 		}
-		if(longestFree>totalLongestFree) totalLongestFree=longestFree;
-		frag[e.idx].bkpFrag=sectionTotalFree?
-				1.0-(double)longestFree/(double)sectionTotalFree : 0.0;
-		frag[e.idx].totalFrag=sectionTotalFree?
-				1.0-(double)totalLongestFree/(double)totalFree : 0.0;
 	}
+	if(longestFree>totalLongestFree) totalLongestFree=longestFree;
+	f.bkpFrag=sectionTotalFree?
+			1.0-(double)longestFree/(double)sectionTotalFree : 0.0;
+	f.totalFrag=sectionTotalFree?
+			1.0-(double)totalLongestFree/(double)totalFree : 0.0;
 }
+
+/**
+ * Update the running metric totals for a fiber, see fiberLink().
+ * Must be called after the frag entries of the fiber have been updated
+ * with updateLinkFrag().
+ * Only the difference to the previously accounted values is applied, so
+ * calling this twice for the same fiber is harmless.
+ */
+template<specIndex_t numSlots>
+void NetworkState<numSlots>::accountLinkMetrics(linkIndex_t fl) {
+	LinkState &l=*links.mut(fl);
+	const linkfrag_t &o=l.accountedFrag, &n=l.frag;
+	current.priEnd+=n.priEnd;
+	current.priEnd-=o.priEnd;
+	current.bkpBegin+=n.bkpBegin;
+	current.bkpBegin-=o.bkpBegin;
+	current.priFrag+=llrint(n.priFrag*FRAG_SCALE)-llrint(o.priFrag*FRAG_SCALE);
+	current.bkpFrag+=llrint(n.bkpFrag*FRAG_SCALE)-llrint(o.bkpFrag*FRAG_SCALE);
+	current.totalFrag+=llrint(n.totalFrag*FRAG_SCALE)-llrint(o.totalFrag*FRAG_SCALE);
+	current.collisions+=(n.bkpBegin<=n.priEnd)-(o.bkpBegin<=o.priEnd);
+	if(o.priEnd==0 && o.bkpBegin==numSlots) current.idleAmps-=linkAmps[fl%numLinks];
+	if(n.priEnd==0 && n.bkpBegin==numSlots) current.idleAmps+=linkAmps[fl%numLinks];
+	l.accountedFrag=n;
+	accountNodeFree(fiberNode(fl),l.accountedUse,l.anyUse);
+	l.accountedUse=l.anyUse;
+}
+
+/**
+ * Update the nodeFree prefix sums of node n after one of its links changed
+ * its used spectrum from "from" to "to".
+ */
+template<specIndex_t numSlots>
+void NetworkState<numSlots>::accountNodeFree(nodeIndex_t n,
+		const spectrum_bits &from, const spectrum_bits &to) {
+	const spectrum_bits changed=from^to;
+	if(changed.none()) return;
+	nodeVersion[n]=++lastVersion;
+	unsigned int * const nf=nodeFree.mut(n);
+	int delta=0;
+	for(specIndex_t i=0; i<numSlots; ++i) {
+		if(changed[i]) delta+=to[i]?-1:1;
+		nf[i+1]+=delta;
+	}
+}
+
+/**
+ * Set the counters to the values of an empty network.
+ */
+template<specIndex_t numSlots>
+void NetworkState<numSlots>::resetCounters() {
+	current=Counters();
+	current.bkpBegin=(uint64_t)numFibers*numLinks*numSlots;
+	current.idleAmps=numFibers*numAmps;
+}
+
+/**
+ * Set the nodeFree prefix sums to the values of an empty network.
+ */
+template<specIndex_t numSlots>
+void NetworkState<numSlots>::resetNodeFree() {
+	for(linkIndex_t l=0; l<numFibers*numLinks; ++l) {
+		unsigned int * const nf=nodeFree.mut(fiberNode(l));
+		for(specIndex_t i=1; i<=numSlots; ++i)
+			nf[i]+=i;
+	}
+}
+
+template<specIndex_t numSlots>
+thread_local typename NetworkState<numSlots>::ReadSet *NetworkState<numSlots>::reads=0;
+
+/**
+ * Record the links and nodes that are read by the const member functions
+ * (and by the helper classes) in r, until trackReads(0) is called.
+ * Tracking applies to the calling thread only, and to all NetworkState
+ * objects with the same number of slots that it reads meanwhile.
+ * Together with getLinkVersion() and getNodeVersion(), this tells if the
+ * result of a computation on this NetworkState is still valid.
+ */
+template<specIndex_t numSlots>
+void NetworkState<numSlots>::trackReads(ReadSet* r) const {
+	reads=r;
+}
+
+/**
+ * A number that changes whenever the link's spectrum usage or its row of
+ * the sharing matrix may have changed. Versions are never reused.
+ */
+template<specIndex_t numSlots>
+uint64_t NetworkState<numSlots>::getLinkVersion(linkIndex_t l) const {
+	return linkVersion[l];
+}
+
+/**
+ * A number that changes whenever the free slots of the node's outgoing
+ * links have changed. Versions are never reused.
+ */
+template<specIndex_t numSlots>
+uint64_t NetworkState<numSlots>::getNodeVersion(nodeIndex_t n) const {
+	return nodeVersion[n];
+}
+
+/**
+ * Start recording changes so that they can be undone with rollback().
+ * Transactions cannot be nested.
+ */
+template<specIndex_t numSlots>
+void NetworkState<numSlots>::begin() {
+	if(inTransaction) throw std::runtime_error("NetworkState: nested transaction");
+	savedCounters=current;
+	inTransaction=true;
+}
+
+/**
+ * Keep all changes since begin() and stop recording.
+ */
+template<specIndex_t numSlots>
+void NetworkState<numSlots>::commit() {
+	linkUndo.clear();
+	sharingUndo.clear();
+	inTransaction=false;
+}
+
+/**
+ * Undo all changes since begin().
+ * The cost is proportional to the number of modified links and sharing
+ * matrix entries, not to the size of the network.
+ */
+template<specIndex_t numSlots>
+void NetworkState<numSlots>::rollback() {
+	PHASE_SCOPE(STATE);
+	if(!inTransaction) throw std::runtime_error("NetworkState: rollback without transaction");
+	for(auto it=sharingUndo.rbegin(); it!=sharingUndo.rend(); ++it)
+		sharing.mut(it->bkp)[it->pri]=it->bits;
+	for(auto it=linkUndo.rbegin(); it!=linkUndo.rend(); ++it) {
+		LinkState &l=*links.mut(it->first);
+		accountNodeFree(fiberNode(it->first),l.accountedUse,it->second.accountedUse);
+		l=it->second;
+		linkVersion[it->first]=++lastVersion;
+	}
+	current=savedCounters;
+	commit();
+}
+
+/**
+ * Get write access to a link, recording its old state in a transaction.
+ */
+template<specIndex_t numSlots>
+typename NetworkState<numSlots>::LinkState& NetworkState<numSlots>::writeLink(linkIndex_t l) {
+	LinkState &r=*links.mut(l);
+	if(inTransaction) linkUndo.push_back(std::make_pair(l,r));
+	linkVersion[l]=++lastVersion;
+	return r;
+}
+
+/**
+ * Get write access to a sharing matrix entry, recording its old value in a
+ * transaction.
+ */
+template<specIndex_t numSlots>
+typename NetworkState<numSlots>::spectrum_bits& NetworkState<numSlots>::writeSharing(linkIndex_t b, linkIndex_t p) {
+	spectrum_bits &r=sharing.mut(b)[p];
+	if(inTransaction) sharingUndo.push_back(SharingUndo({b,p,r}));
+	return r;
+}
+
+template<specIndex_t numSlots>
+NetworkState<numSlots>::ScratchOverlay::ScratchOverlay():
+		scratch()
+{}
+
+/**
+ * Copies get a scratch state of their own on their first attach().
+ */
+template<specIndex_t numSlots>
+NetworkState<numSlots>::ScratchOverlay::ScratchOverlay(const ScratchOverlay &):
+		scratch()
+{}
+
+/**
+ * Make the overlay a copy of s, discarding any earlier trial.
+ */
+template<specIndex_t numSlots>
+void NetworkState<numSlots>::ScratchOverlay::attach(const NetworkState &s) {
+	if(scratch) *scratch=s;
+	else scratch.reset(new NetworkState(s));
+}
+
+/**
+ * Provision p on the copy. Only one trial can be open at a time.
+ * @return The copy with p provisioned, valid until the next undo() or attach().
+ */
+template<specIndex_t numSlots>
+const NetworkState<numSlots> &NetworkState<numSlots>::ScratchOverlay::tryProvision(const Provisioning &p) {
+	scratch->begin();
+	scratch->provision(p);
+	return *scratch;
+}
+
+/**
+ * Undo the last tryProvision(), so that the copy equals the attached state again.
+ */
+template<specIndex_t numSlots>
+void NetworkState<numSlots>::ScratchOverlay::undo() {
+	scratch->rollback();
+}
+
+template<specIndex_t numSlots>
+NetworkState<numSlots>::ProtectionRows::ProtectionRows():
+		s(nullptr),
+		priPath(),
+		rows(),
+		rowGen(),
+		gen(0)
+{}
+
+/**
+ * Select the state and the primary path for the following queries.
+ * Invalidates all rows; the buffers are only reallocated if the state has
+ * a different number of fiber links than the last one.
+ */
+template<specIndex_t numSlots>
+void NetworkState<numSlots>::ProtectionRows::setPrimary(const NetworkState& s,
+		const NetworkGraph::Path& priPath) {
+	PHASE_SCOPE(SPECTRUM);
+	const size_t n=(size_t)s.numFibers*s.numLinks;
+	if(rowGen.size()!=n) {
+		rows.resize(n);
+		rowGen.assign(n,0);
+	}
+	this->s=&s;
+	this->priPath=priPath;
+	if(++gen==0) {
+		std::fill(rowGen.begin(),rowGen.end(),0);
+		gen=1;
+	}
+}
+
+/**
+ * The spectrum that is blocked for a backup of the primary path on one fiber of a link.
+ */
+template<specIndex_t numSlots>
+const typename NetworkState<numSlots>::spectrum_bits& NetworkState<numSlots>::ProtectionRows::row(
+		const NetworkGraph::Graph::edge_descriptor bkpLink, fiberIndex_t fiber) {
+	if(!s) throw std::runtime_error("ProtectionRows: no primary path selected");
+	const linkIndex_t b=s->fiberLink(bkpLink.idx,fiber);
+	if(rowGen[b]!=gen) {
+		rows[b]=s->bkpAvailability(priPath,bkpLink,fiber);
+		rowGen[b]=gen;
+	}
+	return rows[b];
+}
+
+/**
+ * Same as NetworkState::bkpAvailability(priPath,bkpPath) for the selected primary.
+ */
+template<specIndex_t numSlots>
+typename NetworkState<numSlots>::spectrum_bits NetworkState<numSlots>::ProtectionRows::bkpAvailability(
+		const NetworkGraph::Path& bkpPath, fiberIndex_t fiber) {
+	PHASE_SCOPE(SPECTRUM);
+	spectrum_bits result;
+	for(auto const &e:bkpPath)
+		result|=row(e,fiber);
+	return result;
+}
+
+/**
+ * First-fit over all fibers of a backup path for the selected primary.
+ * Lower fibers are preferred over lower slots.
+ * @return false if no fiber has width consecutive free slots.
+ */
+template<specIndex_t numSlots>
+bool NetworkState<numSlots>::ProtectionRows::firstFit(const NetworkGraph::Path& bkpPath,
+		specIndex_t width, fiberIndex_t& fiber, specIndex_t& begin) {
+	PHASE_SCOPE(SPECTRUM);
+	if(!s) throw std::runtime_error("ProtectionRows: no primary path selected");
+	for(fiberIndex_t f=0; f<s->numFibers; ++f) {
+		const specIndex_t b=NetworkState::firstFit(bkpAvailability(bkpPath,f),width);
+		if(b<numSlots) {
+			fiber=f;
+			begin=b;
+			return true;
+		}
+	}
+	return false;
+}
+
+template<specIndex_t numSlots>
+NetworkState<numSlots>::TrieAvailability::TrieAvailability(const NetworkState& s,
+		const NetworkGraph::PathTrie& trie):
+		s(s),
+		trie(trie),
+		avail(s.numFibers),
+		done(1,true)
+{}
+
+/**
+ * The same as NetworkState::priAvailability() for the path that ends at trie.leaves[path].
+ */
+template<specIndex_t numSlots>
+const typename NetworkState<numSlots>::spectrum_bits& NetworkState<numSlots>::TrieAvailability::priAvailability(
+		size_t path, fiberIndex_t fiber) {
+	PHASE_SCOPE(SPECTRUM);
+	if(done.size()<trie.nodes.size()) {
+		avail.resize(trie.nodes.size()*s.numFibers);
+		done.resize(trie.nodes.size(),false);
+	}
+	return node(trie.leaves[path])[fiber];
+}
+
+/**
+ * First-fit over all fibers of a path. Lower fibers are preferred over
+ * lower slots.
+ * @return false if no fiber has width consecutive free slots.
+ */
+template<specIndex_t numSlots>
+bool NetworkState<numSlots>::TrieAvailability::firstFit(size_t path, specIndex_t width,
+		fiberIndex_t& fiber, specIndex_t& begin) {
+	PHASE_SCOPE(SPECTRUM);
+	const spectrum_bits * const a=&priAvailability(path);
+	for(fiberIndex_t f=0; f<s.numFibers; ++f) {
+		const specIndex_t b=NetworkState::firstFit(a[f],width);
+		if(b<numSlots) {
+			fiber=f;
+			begin=b;
+			return true;
+		}
+	}
+	return false;
+}
+
+/// The availability of all fibers at trie node n.
+template<specIndex_t numSlots>
+const typename NetworkState<numSlots>::spectrum_bits *NetworkState<numSlots>::TrieAvailability::node(
+		size_t n) {
+	const spectrum_bits * const result=&avail[n*s.numFibers];
+	if(!done[n]) {
+		const NetworkGraph::PathTrie::Node &tn=trie.nodes[n];
+		const spectrum_bits * const parent=node(tn.parent);
+		for(fiberIndex_t f=0; f<s.numFibers; ++f)
+			avail[n*s.numFibers+f]=parent[f]|s.readLink(s.fiberLink(tn.edge.idx,f)).anyUse;
+		done[n]=true;
+	}
+	return result;
+}
+
+#define INSTANTIATE_NETWORKSTATE(n) template class NetworkState<n>;
+FOR_EACH_NUM_SLOTS(INSTANTIATE_NETWORKSTATE)
@@ -23,10 +23,15 @@
 #ifndef NETWORKSTATE_H_
 #define NETWORKSTATE_H_
 
+#include <array>
 #include <bitset>
 #include <cstdint>
 #include <map>
+#include <memory>
+#include <vector>
 
+#include "ConnectionQueue.h"
+#include "CowArray.h"
 #include "globaldef.h"
 #include "modulation.h"
 #include "NetworkGraph.h"
@@ -35,62 +40,288 @@
 
 /**
  * \brief Maintains the network's spectrum state during a simulation run.
+ *
+ * The per-link state and the sharing matrix are stored with link granularity
+ * in CowArray objects, so copying a NetworkState is cheap: The copy shares
+ * all links with the original until one of them modifies a link.
+ * This is used to fork simulations from a common (warmed-up) state.
+ *
+ * The number of spectrum slots per link is a template parameter, see
+ * FOR_EACH_NUM_SLOTS.
+ *
+ * Each link may consist of several parallel fibers (or cores), each with
+ * its own spectrum. Internally, every fiber is handled like a link of its
+ * own; the per-fiber state is stored fiber-major, i.e. fiber f of link l
+ * has the index f*numLinks+l. A connection stays on one fiber along each
+ * of its paths. The sharing matrix is indexed by backup fiber and primary
+ * link, since all fibers of a link fail together, so its size grows
+ * linearly with the number of fibers.
  */
-class NetworkState {
+template<specIndex_t numSlots> class NetworkState {
 public:
-	NetworkState(const NetworkGraph &topology);
+	NetworkState(const NetworkGraph &topology, fiberIndex_t numFibers=1);
 	virtual ~NetworkState();
 	void provision(const Provisioning &p);
 	void terminate(const Provisioning &p);
+	void terminate(const std::vector<const Provisioning*> &batch);
 	void reset();
-	typedef std::bitset<NUM_SLOTS> spectrum_bits;
-	spectrum_bits priAvailability(const NetworkGraph::Path &priPath) const;
+	void begin();
+	void commit();
+	void rollback();
+	typedef std::bitset<numSlots> spectrum_bits;
+	fiberIndex_t getNumFibers() const;
+	static specIndex_t firstFit(const spectrum_bits &used, specIndex_t width);
+	spectrum_bits priAvailability(const NetworkGraph::Path &priPath,
+			fiberIndex_t fiber=0) const;
 	spectrum_bits bkpAvailability(
 			const NetworkGraph::Path &priPath,
-			const NetworkGraph::Graph::edge_descriptor bkpLink) const;
+			const NetworkGraph::Graph::edge_descriptor bkpLink,
+			fiberIndex_t fiber=0) const;
 	spectrum_bits bkpAvailability(
 			const NetworkGraph::Path &priPath,
-			const NetworkGraph::Path &bkpPath) const;
+			const NetworkGraph::Path &bkpPath,
+			fiberIndex_t fiber=0) const;
 	StatCounter::PerfMetrics getCurrentPerfMetrics() const;
+	double getMaxUtilization() const;
+	static void estimateMemory(linkIndex_t numLinks, nodeIndex_t numNodes,
+			fiberIndex_t numFibers, StatCounter::Memory &m);
+	void countMemory(StatCounter::Memory &m) const;
 
-	void sanityCheck(const std::multimap<unsigned long, Provisioning> &conns) const;
+	void sanityCheck(const ConnectionQueue &conns) const;
+	bool checkLink(linkIndex_t l) const;
+
+	/**
+	 * \brief The links and nodes whose state was read while tracking was enabled.
+	 * May contain duplicates. Both are numbered per fiber, i.e. fiber f of
+	 * link l is f*numLinks+l and node n in fiber f is f*numNodes+n.
+	 */
+	struct ReadSet {
+		std::vector<linkIndex_t> links;
+		std::vector<nodeIndex_t> nodes;
+	};
+	void trackReads(ReadSet *r) const;
+	uint64_t getLinkVersion(linkIndex_t l) const;
+	uint64_t getNodeVersion(nodeIndex_t n) const;
 
 	//uint64_t getCurrentBkpBw() const;
 
 	unsigned int calcCuts(const NetworkGraph& g, const NetworkGraph::Path &p,
-			const specIndex_t begin, const specIndex_t end) const;
+			const specIndex_t begin, const specIndex_t end, fiberIndex_t fiber=0) const;
 	double calcMisalignments(const NetworkGraph& g, const NetworkGraph::Path &p,
-			const specIndex_t begin, const specIndex_t end) const;
+			const specIndex_t begin, const specIndex_t end, fiberIndex_t fiber=0) const;
 	unsigned int countFreeBlocks(const NetworkGraph::Path& bkpPath,
-			specIndex_t i) const;
+			specIndex_t i, fiberIndex_t fiber=0) const;
 	unsigned int countFreeBlocks(const NetworkGraph::Path &p,
-			const specIndex_t begin, const specIndex_t end) const;
+			const specIndex_t begin, const specIndex_t end, fiberIndex_t fiber=0) const;
+	/**
+	 * Prefix sums of countFreeBlocks(p,i) over all slots: Entry i holds the
+	 * number of free (link, slot) pairs of a path in the slots [0,i), so
+	 * countFreeBlocks(p,begin,end) is t[end]-t[begin].
+	 */
+	typedef std::array<unsigned int, numSlots+1> free_blocks_t;
+	free_blocks_t freeBlockTable(const NetworkGraph::Path &p, fiberIndex_t fiber=0) const;
+
+	/**
+	 * \brief Computes priAvailability() for the paths in a NetworkGraph::PathTrie.
+	 *
+	 * The availability of a trie node is that of its parent ORed with the
+	 * anyUse of its edge, so a prefix shared by several candidate paths is
+	 * only evaluated once. Nodes are evaluated on first use, so looking at
+	 * only the first few paths does not cost more than priAvailability().
+	 * The trie may grow between calls, but the NetworkState must not change.
+	 *
+	 * All fibers of a node are evaluated together, so a first-fit search
+	 * over all fibers of a path takes a single pass over its links.
+	 */
+	class TrieAvailability {
+	public:
+		TrieAvailability(const NetworkState &s, const NetworkGraph::PathTrie &trie);
+		const spectrum_bits &priAvailability(size_t path, fiberIndex_t fiber=0);
+		bool firstFit(size_t path, specIndex_t width, fiberIndex_t &fiber, specIndex_t &begin);
+	private:
+		const NetworkState &s;
+		const NetworkGraph::PathTrie &trie;
+		/// The availability of fiber f at trie node n is avail[n*numFibers+f].
+		std::vector<spectrum_bits> avail;
+		std::vector<bool> done;
+		const spectrum_bits *node(size_t n);
+	};
+
+	/**
+	 * \brief Caches bkpAvailability() per backup link for one primary path.
+	 *
+	 * When many backup candidates are evaluated for the same primary, most
+	 * of them share links. The blocked spectrum of each backup link is
+	 * computed on first use and reused for all later candidates, so the
+	 * availability of a backup path is only an OR over its links' rows.
+	 * The rows are only valid as long as the NetworkState is not modified.
+	 * Schemes keep one as a member, so that its buffers are reused for all
+	 * requests.
+	 */
+	class ProtectionRows {
+	public:
+		ProtectionRows();
+		void setPrimary(const NetworkState &s, const NetworkGraph::Path &priPath);
+		const spectrum_bits &row(const NetworkGraph::Graph::edge_descriptor bkpLink,
+				fiberIndex_t fiber=0);
+		spectrum_bits bkpAvailability(const NetworkGraph::Path &bkpPath, fiberIndex_t fiber=0);
+		bool firstFit(const NetworkGraph::Path &bkpPath, specIndex_t width,
+				fiberIndex_t &fiber, specIndex_t &begin);
+	private:
+		/// The state of the last setPrimary(), or nullptr.
+		const NetworkState *s;
+		NetworkGraph::Path priPath;
+		/// Indexed by backup fiber, like the links of the NetworkState.
+		std::vector<spectrum_bits> rows;
+		/// rows[l] is valid if rowGen[l]==gen. Generations start at 1, so a zeroed entry is never valid.
+		std::vector<unsigned int> rowGen;
+		unsigned int gen;
+	};
+
+	/**
+	 * \brief A scratch copy of a NetworkState on which a scheme can try out Provisionings.
+	 *
+	 * Schemes only get a const NetworkState. attach() makes the overlay a
+	 * copy of it, which shares all links with the original until they are
+	 * modified, see CowArray. tryProvision() applies a candidate to the copy
+	 * in a transaction and undo() rolls it back from the undo log, so the
+	 * candidates of one request can be tried one after the other without
+	 * copying again. The original is never modified.
+	 * Schemes keep one as a member, so that its buffers are reused for all
+	 * requests.
+	 */
+	class ScratchOverlay {
+	public:
+		ScratchOverlay();
+		ScratchOverlay(const ScratchOverlay &);
+		void attach(const NetworkState &s);
+		const NetworkState &tryProvision(const Provisioning &p);
+		void undo();
+	private:
+		std::unique_ptr<NetworkState> scratch;
+	};
 
 private:
-	NetworkState(const NetworkState &n);
 	linkIndex_t numLinks;
 	nodeIndex_t numNodes;
+	fiberIndex_t numFibers;
+	/// The number of amplifiers on one fiber of each link, summed over all links.
 	unsigned long numAmps;
-	spectrum_bits *primaryUse;
-	spectrum_bits *anyUse;
-	/**
-	 * This is a two-dimensional array of size numLinks^2.
-	 * The bitset at sharing[i*numLinks+j] defines
-	 * the backup spectrum in link i that protects primaries in j.
-	 */
-	spectrum_bits *sharing;
-	uint64_t currentPriSlots;
-	uint64_t currentBkpSlots;
-	uint64_t currentBkpLpSlots;
-	uint64_t currentTxSlots[MOD_NONE];
 	typedef struct LinkFrag{
 		specIndex_t priEnd, bkpBegin;
 		double priFrag, bkpFrag, totalFrag;
 		LinkFrag();
 	} linkfrag_t;
-	linkfrag_t *frag;
-	unsigned short *linkAmps;
-	void updateLinkFrag(const NetworkGraph::Path &p);
+	/**
+	 * \brief Everything that NetworkState stores about a single link.
+	 */
+	struct LinkState{
+		spectrum_bits primaryUse;
+		spectrum_bits anyUse;
+		linkfrag_t frag;
+		/**
+		 * The frag values that are currently included in the running totals
+		 * in NetworkState::current. Kept separately so that accountLinkMetrics() can be called
+		 * more than once for the same link without counting it twice.
+		 */
+		linkfrag_t accountedFrag;
+		/// The anyUse value that is currently included in NetworkState::nodeFree.
+		spectrum_bits accountedUse;
+	};
+	/// One page per fiber, see fiberLink().
+	CowArray<LinkState> links;
+	/**
+	 * This is a two-dimensional array of size (numFibers*numLinks)*numLinks,
+	 * one page per row.
+	 * The bitset at sharing[i][j] defines
+	 * the backup spectrum in fiber i that protects primaries in link j
+	 * (on any of its fibers).
+	 */
+	CowArray<spectrum_bits> sharing;
+	/**
+	 * Prefix sums of the number of free outgoing links per node and slot,
+	 * one page of numSlots+1 entries per node and fiber (see fiberNode()):
+	 * nodeFree[n][i] is the number of free (outgoing link, slot) pairs of
+	 * node n in the slots [0,i).
+	 * This makes calcMisalignments() independent of the node degree and
+	 * the window width.
+	 */
+	CowArray<unsigned int> nodeFree;
+	/// The source node of each link.
+	std::vector<nodeIndex_t> linkSource;
+	std::vector<unsigned short> linkAmps;
+	/**
+	 * \brief Network-wide counters.
+	 *
+	 * Besides the slot counters, these are the running totals of the
+	 * per-link metrics, so that getCurrentPerfMetrics() does not have to
+	 * loop over all links.
+	 */
+	struct Counters{
+		uint64_t priSlots;
+		uint64_t bkpSlots;
+		uint64_t bkpLpSlots;
+		uint64_t txSlots[MOD_NONE];
+		uint64_t priEnd, bkpBegin;
+		/// Sums of the links' fragmentation in units of 1/FRAG_SCALE, so they do not drift.
+		int64_t priFrag, bkpFrag, totalFrag;
+		linkIndex_t collisions;
+		unsigned long idleAmps;
+	} current;
+
+	/**
+	 * \brief Undo log entry for one bitset of the sharing matrix.
+	 */
+	struct SharingUndo{
+		linkIndex_t bkp, pri;
+		spectrum_bits bits;
+	};
+	bool inTransaction;
+	Counters savedCounters;
+	std::vector<std::pair<linkIndex_t, LinkState> > linkUndo;
+	std::vector<SharingUndo> sharingUndo;
+	LinkState &writeLink(linkIndex_t l);
+	spectrum_bits &writeSharing(linkIndex_t b, linkIndex_t p);
+
+	std::vector<uint64_t> linkVersion, nodeVersion;
+	uint64_t lastVersion;
+	/// Per thread, so that several threads can track their reads of the same NetworkState.
+	static thread_local ReadSet *reads;
+	/// Read access to a link (and its sharing row) for the const member functions.
+	const LinkState &readLink(linkIndex_t l) const {
+		if(reads) reads->links.push_back(l);
+		return *links[l];
+	}
+	/// Read access to a node's nodeFree prefix sums for the const member functions.
+	const unsigned int *readNodeFree(nodeIndex_t n) const {
+		if(reads) reads->nodes.push_back(n);
+		return nodeFree[n];
+	}
+
+	/// Scratch space of terminate(): The union of the freed backup spectrum per link.
+	std::vector<spectrum_bits> freedBkp;
+	/// Scratch space of terminate(): Per-link flags, see the TERM_* constants.
+	std::vector<unsigned char> termFlags;
+	enum {TERM_TOUCHED=1, TERM_BKP=2, TERM_BKP_BEGIN=4};
+	/// Scratch space of terminate(): The modified links and the backup links to rebuild.
+	std::vector<linkIndex_t> touched, rebuild;
+	void terminate(const Provisioning *const *begin, const Provisioning *const *end);
+
+	/// The index of fiber f of link l in links, sharing and linkVersion.
+	linkIndex_t fiberLink(linkIndex_t l, fiberIndex_t f) const {
+		return f*numLinks+l;
+	}
+	/// The index of the source node of fiber l (see fiberLink()) in nodeFree and nodeVersion.
+	nodeIndex_t fiberNode(linkIndex_t l) const {
+		return l/numLinks*numNodes+linkSource[l%numLinks];
+	}
+
+	void updateLinkFrag(linkIndex_t l);
+	static void calcLinkFrag(const spectrum_bits &anyUse, linkfrag_t &f);
+	void accountLinkMetrics(linkIndex_t l);
+	void accountNodeFree(nodeIndex_t n, const spectrum_bits &from, const spectrum_bits &to);
+	void resetCounters();
+	void resetNodeFree();
 };
 
 #endif /* NETWORKSTATE_H_ */
@@ -0,0 +1,49 @@
+/**
+ * @file PhaseTimer.cpp
+ *
+ */
+
+/*
+ * This file is part of eonsim.
+ *
+ * eonsim is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * eonsim is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with eonsim.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#include "PhaseTimer.h"
+
+#ifdef PHASE_TIMERS
+
+const char *const PhaseTimer::names[NUM_PHASES]={"Other","Paths","Spectrum","Cost","State","Stats"};
+thread_local PhaseTimer::phase_t PhaseTimer::phase=PhaseTimer::OTHER;
+thread_local uint64_t PhaseTimer::last=0;
+thread_local PhaseTimer::Ticks *PhaseTimer::ticks=nullptr;
+
+PhaseTimer::Run::Run(Ticks &t):
+	prevTicks(ticks),
+	prevPhase(phase)
+{
+	flush();
+	ticks=&t;
+	phase=OTHER;
+	last=now();
+}
+
+PhaseTimer::Run::~Run() {
+	flush();
+	ticks=prevTicks;
+	phase=prevPhase;
+	last=now();
+}
+
+#endif /* PHASE_TIMERS */
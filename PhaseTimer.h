@@ -0,0 +1,107 @@
+/**
+ * @file PhaseTimer.h
+ *
+ */
+
+/*
+ * This file is part of eonsim.
+ *
+ * eonsim is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * eonsim is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with eonsim.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#ifndef PHASETIMER_H_
+#define PHASETIMER_H_
+
+#ifdef PHASE_TIMERS
+
+#include <array>
+#include <chrono>
+#include <cstdint>
+#if defined(__x86_64__) || defined(__i386__)
+#include <x86intrin.h>
+#endif
+
+/**
+ * \brief Splits the time of a run into the phases of the simulation.
+ *
+ * A PhaseTimer marks a phase for its lifetime, see PHASE_SCOPE. The ticks
+ * between two phase changes are charged to the phase that was active, so a
+ * phase that is entered within another one (e.g. a spectrum search within
+ * the cost evaluation of a heuristic) takes over until it ends, and
+ * everything outside of all marked phases is OTHER. The clock is only read
+ * when the phase changes. Ticks are only counted on threads with an active
+ * Run.
+ *
+ * The ticks are CPU cycles from the time stamp counter on x86, and
+ * nanoseconds elsewhere. This class only exists if eonsim is built with
+ * the CMake option PHASE_TIMERS; otherwise PHASE_SCOPE expands to nothing.
+ */
+class PhaseTimer {
+public:
+	enum phase_t {OTHER, PATHS, SPECTRUM, COST, STATE, STATS, NUM_PHASES};
+	typedef std::array<uint64_t, NUM_PHASES> Ticks;
+	/// The column titles of the phases.
+	static const char *const names[NUM_PHASES];
+	explicit PhaseTimer(phase_t p): prev(phase) {enter(p);}
+	~PhaseTimer() {enter(prev);}
+	static uint64_t now() {
+#if defined(__x86_64__) || defined(__i386__)
+		return __rdtsc();
+#else
+		return std::chrono::duration_cast<std::chrono::nanoseconds>(
+				std::chrono::steady_clock::now().time_since_epoch()).count();
+#endif
+	}
+	/// Charge the ticks up to now, e.g. before the counts are read.
+	static void flush() {
+		if(!ticks) return;
+		const uint64_t t=now();
+		(*ticks)[phase]+=t-last;
+		last=t;
+	}
+	/**
+	 * \brief Counts the ticks of the calling thread into one array for its lifetime.
+	 *
+	 * A Run within another one suspends the outer Run.
+	 */
+	class Run {
+	public:
+		explicit Run(Ticks &t);
+		~Run();
+	private:
+		Ticks *prevTicks;
+		phase_t prevPhase;
+		Run(const Run &);
+	};
+private:
+	phase_t prev;
+	static void enter(phase_t p) {
+		if(p==phase) return;
+		flush();
+		phase=p;
+	}
+	static thread_local phase_t phase;
+	static thread_local uint64_t last;
+	static thread_local Ticks *ticks;
+};
+
+#define PHASE_SCOPE(p) PhaseTimer phaseTimer(PhaseTimer::p)
+
+#else
+
+#define PHASE_SCOPE(p)
+
+#endif /* PHASE_TIMERS */
+
+#endif /* PHASETIMER_H_ */
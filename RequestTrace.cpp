@@ -0,0 +1,200 @@
+/**
+ * @file RequestTrace.cpp
+ *
+ */
+
+/*
+ * This file is part of eonsim.
+ *
+ * eonsim is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * eonsim is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with eonsim.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#include "RequestTrace.h"
+
+#include <boost/random/exponential_distribution.hpp>
+#include <boost/random/taus88.hpp>
+#include <boost/random/uniform_int_distribution.hpp>
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+#include <algorithm>
+#include <cmath>
+#include <cstring>
+#include <stdexcept>
+
+namespace {
+const char magic[8]={'E','O','N','T','R','C','0','1'};
+
+void putLE(std::ofstream &out, uint64_t v, size_t bytes) {
+	for(size_t i=0; i<bytes; ++i, v>>=8) out.put((char)(v&0xff));
+}
+
+uint64_t getLE(const unsigned char *p, size_t bytes) {
+	uint64_t v=0;
+	for(size_t i=bytes; i>0; --i) v=(v<<8)|p[i-1];
+	return v;
+}
+}
+
+TraceWriter::TraceWriter(const std::string& fileName):
+	out(fileName,std::ofstream::binary|std::ofstream::trunc),
+	lastArrival(0),
+	numRecords(0),
+	numNodes(0)
+{
+	if(!out) throw std::runtime_error("Can not write the trace file "+fileName);
+	out.write(magic,sizeof(magic));
+	putLE(out,0,8);
+	putLE(out,0,4);
+}
+
+TraceWriter::~TraceWriter() {
+	if(out.is_open()) close();
+}
+
+void TraceWriter::putVarint(uint64_t v) {
+	while(v>=0x80) {
+		out.put((char)(v|0x80));
+		v>>=7;
+	}
+	out.put((char)v);
+}
+
+void TraceWriter::write(const TraceRecord& r) {
+	if(r.arrival<lastArrival)
+		throw std::invalid_argument("Trace records must be written in the order of their arrival");
+	if(r.source==r.dest)
+		throw std::invalid_argument("Trace records must have different source and destination");
+	putVarint(r.arrival-lastArrival);
+	putVarint(r.holding);
+	putVarint(r.source);
+	putVarint(r.dest);
+	putVarint(r.bandwidth);
+	lastArrival=r.arrival;
+	numNodes=std::max<nodeIndex_t>(numNodes,std::max(r.source,r.dest)+1);
+	++numRecords;
+}
+
+/**
+ * Fill in the header and close the file.
+ */
+void TraceWriter::close() {
+	out.seekp(sizeof(magic));
+	putLE(out,numRecords,8);
+	putLE(out,numNodes,4);
+	out.close();
+}
+
+/**
+ * The random number generator and the distributions are the same as in
+ * Simulation::simulate(), and it starts from the same seed. The holding
+ * time is drawn for every request, whereas the simulation only draws it
+ * for the provisioned ones, so the holding times of a run from the trace
+ * differ from a generated run once the first request is blocked.
+ */
+void TraceWriter::generate(const std::string &fileName, nodeIndex_t numNodes,
+		const ProvisioningSchemeBase::ParameterSet &params, const TrafficMatrix *traffic) {
+	const unsigned long iters=params.at("iters");
+	const unsigned int load=params.at("load");
+	boost::random::taus88 rng;
+	rng.seed(0);
+	boost::random::exponential_distribution<> requestTimeGen(1.0/AVG_INTARRIVAL);
+	boost::random::exponential_distribution<> holdingTimeGen(1.0/(AVG_INTARRIVAL*load));
+	boost::random::uniform_int_distribution<size_t> sourceGen(0,numNodes-1);
+	boost::random::uniform_int_distribution<size_t> destGen(0,numNodes-2);
+	boost::random::uniform_int_distribution<unsigned int>bandwidthGen(
+			params.at("bwmin"), params.at("bwmax"));
+	TraceWriter w(fileName);
+	TraceRecord r;
+	r.arrival=0;
+	for(unsigned long i=0; i<iters; ++i) {
+		if(traffic) {
+			if(!(*traffic)(rng,r.source,r.dest,r.bandwidth)) r.bandwidth=bandwidthGen(rng);
+		} else {
+			r.source=sourceGen(rng);
+			r.dest=destGen(rng);
+			if(r.dest>=r.source) ++r.dest;
+			r.bandwidth=bandwidthGen(rng);
+		}
+		r.holding=lrint(holdingTimeGen(rng));
+		w.write(r);
+		r.arrival+=lrint(requestTimeGen(rng));
+	}
+	w.close();
+}
+
+TraceFile::TraceFile(const std::string& fileName):
+	data(nullptr),
+	size(0),
+	numRecords(0),
+	numNodes(0)
+{
+	int fd=open(fileName.c_str(),O_RDONLY);
+	if(fd<0) throw std::runtime_error("Can not open the trace file "+fileName);
+	struct stat st;
+	if(fstat(fd,&st)!=0 || (size_t)st.st_size<headerSize) {
+		::close(fd);
+		throw std::runtime_error(fileName+" is not a trace file");
+	}
+	size=st.st_size;
+	void *p=mmap(nullptr,size,PROT_READ,MAP_SHARED,fd,0);
+	::close(fd);
+	if(p==MAP_FAILED) throw std::runtime_error("Can not map the trace file "+fileName);
+	data=static_cast<const unsigned char*>(p);
+	if(memcmp(data,magic,sizeof(magic))!=0) {
+		munmap(p,size);
+		throw std::runtime_error(fileName+" is not a trace file");
+	}
+	numRecords=getLE(data+sizeof(magic),8);
+	numNodes=getLE(data+sizeof(magic)+8,4);
+	madvise(p,size,MADV_SEQUENTIAL);
+}
+
+TraceFile::~TraceFile() {
+	munmap(const_cast<unsigned char*>(data),size);
+}
+
+TraceReader::TraceReader():
+	pos(nullptr),
+	end(nullptr),
+	lastArrival(0)
+{}
+
+TraceReader::TraceReader(const TraceFile& f):
+	pos(f.data+TraceFile::headerSize),
+	end(f.data+f.size),
+	lastArrival(0)
+{}
+
+uint64_t TraceReader::getVarint() {
+	uint64_t v=0;
+	for(unsigned int shift=0; ; shift+=7) {
+		if(pos==end || shift>63) throw std::runtime_error("Truncated or corrupt trace file");
+		const unsigned char b=*pos++;
+		v|=(uint64_t)(b&0x7f)<<shift;
+		if(!(b&0x80)) return v;
+	}
+}
+
+bool TraceReader::next(TraceRecord& r) {
+	if(pos==end) return false;
+	lastArrival+=getVarint();
+	r.arrival=lastArrival;
+	r.holding=getVarint();
+	r.source=getVarint();
+	r.dest=getVarint();
+	r.bandwidth=getVarint();
+	return true;
+}
@@ -0,0 +1,124 @@
+/**
+ * @file RequestTrace.h
+ *
+ */
+
+/*
+ * This file is part of eonsim.
+ *
+ * eonsim is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * eonsim is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with eonsim.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#ifndef REQUESTTRACE_H_
+#define REQUESTTRACE_H_
+
+#include <stddef.h>
+#include <cstdint>
+#include <fstream>
+#include <string>
+
+#include "globaldef.h"
+#include "provisioning_schemes/ProvisioningScheme.h"
+#include "TrafficMatrix.h"
+
+/**
+ * \brief One connection request of a trace.
+ */
+struct TraceRecord {
+	simtime_t arrival;
+	simtime_t holding;
+	nodeIndex_t source, dest;
+	/// The requested bandwidth in Gbit/s, before it is converted to slots.
+	unsigned int bandwidth;
+};
+
+/**
+ * \brief Writes a request trace file.
+ *
+ * The file starts with a header of the magic string "EONTRC01", the number
+ * of records and the number of nodes (both little endian, 64 and 32 bits),
+ * which are filled in by close(). Each record is a sequence of unsigned
+ * LEB128 varints: the time since the previous arrival, the holding time,
+ * the source, the destination and the bandwidth. A typical record takes
+ * 8-10 bytes.
+ */
+class TraceWriter {
+public:
+	TraceWriter(const std::string &fileName);
+	~TraceWriter();
+	/// Arrivals must not decrease, and the source must differ from the destination.
+	void write(const TraceRecord &r);
+	void close();
+	uint64_t getNumRecords() const {return numRecords;}
+	/**
+	 * Write the requests that the built-in generator of Simulation
+	 * produces for the parameters load, iters, bwmin and bwmax, and
+	 * optionally a traffic matrix.
+	 */
+	static void generate(const std::string &fileName, nodeIndex_t numNodes,
+			const ProvisioningSchemeBase::ParameterSet &params,
+			const TrafficMatrix *traffic=nullptr);
+private:
+	std::ofstream out;
+	simtime_t lastArrival;
+	uint64_t numRecords;
+	nodeIndex_t numNodes;
+	void putVarint(uint64_t v);
+	TraceWriter(const TraceWriter &);
+};
+
+/**
+ * \brief A request trace file mapped into memory.
+ *
+ * The file is mapped read-only and can be shared by all threads, each
+ * reading it with its own TraceReader. Pages are only loaded when they are
+ * read and can be dropped by the kernel at any time, so a trace does not
+ * need to fit into memory.
+ */
+class TraceFile {
+public:
+	/// Throws std::runtime_error if the file can not be mapped or is not a trace.
+	TraceFile(const std::string &fileName);
+	~TraceFile();
+	uint64_t getNumRecords() const {return numRecords;}
+	/// One more than the highest node index in the trace.
+	nodeIndex_t getNumNodes() const {return numNodes;}
+private:
+	friend class TraceReader;
+	const unsigned char *data;
+	size_t size;
+	uint64_t numRecords;
+	nodeIndex_t numNodes;
+	static const size_t headerSize=20;
+	TraceFile(const TraceFile &);
+};
+
+/**
+ * \brief Reads the records of a TraceFile in order.
+ *
+ * A reader is a cursor into the mapping, so copying it saves the position.
+ */
+class TraceReader {
+public:
+	TraceReader();
+	explicit TraceReader(const TraceFile &f);
+	/// Read the next record. Returns false at the end of the trace.
+	bool next(TraceRecord &r);
+private:
+	const unsigned char *pos, *end;
+	simtime_t lastArrival;
+	uint64_t getVarint();
+};
+
+#endif /* REQUESTTRACE_H_ */
@@ -23,111 +23,1007 @@
 #include "Simulation.h"
 
 #include <boost/graph/compressed_sparse_row_graph.hpp>
-#include <boost/random/exponential_distribution.hpp>
-#include <boost/random/taus88.hpp>
-#include <boost/random/uniform_int_distribution.hpp>
 #include <stddef.h>
+#include <algorithm>
 #include <cmath>
+#include <iostream>
+#include <iterator>
+#include <limits>
 #include <memory>
+#include <sstream>
 #include <utility>
 
 #include "globaldef.h"
+#include "PhaseTimer.h"
+#include "provisioning_schemes/MemoProvisioning.h"
 #include "provisioning_schemes/ProvisioningSchemeFactory.h"
+#include "SpeculativeProvisioner.h"
 #include "StatCounter.h"
 
-Simulation::~Simulation() {
+namespace {
+/// The finalizer of splitmix64, which turns consecutive numbers into unrelated seeds.
+uint32_t splitmix64(uint64_t z) {
+	z+=0x9e3779b97f4a7c15ULL;
+	z=(z^(z>>30))*0xbf58476d1ce4e5b9ULL;
+	z=(z^(z>>27))*0x94d049bb133111ebULL;
+	return (uint32_t)(z^(z>>31));
+}
+}
+
+template<specIndex_t numSlots>
+Simulation<numSlots>::~Simulation() {
 }
 
-Simulation::Simulation(const NetworkGraph& topology):
+template<specIndex_t numSlots>
+Simulation<numSlots>::Simulation(const NetworkGraph& topology, const TraceFile *trace,
+		const TrafficMatrix *traffic, const WarmStateLibrary *library):
 				topology(topology),
 				scratchpad(topology),
-				state(topology)
+				state(topology),
+				activeConnections(std::make_shared<ConnectionQueue>()),
+				failures(topology),
+				checker(topology),
+				currentTime(0),
+				nextRequestTime(0),
+				trace(trace),
+				traceReader(),
+				nextRecord(),
+				traceValid(false),
+				traffic(traffic),
+				library(library),
+				job(nullptr),
+				provision(),
+				count(0),
+				failSample(0),
+				relci(0),
+				checkedSamples(0),
+				precise(false),
+				numProvisionings(0),
+				offered(),
+				memStart(),
+				connBytes(0),
+				peakConnBytes(0),
+				lanes(),
+				retrials()
+{}
+
+template<specIndex_t numSlots>
+Simulation<numSlots>::RequestGenerator::RequestGenerator(const NetworkGraph &topology,
+		const JobIterator::job_t &job):
+		requestTime(1.0/AVG_INTARRIVAL),
+		holdingTime(1.0/(AVG_INTARRIVAL*job.params.at("load"))),
+		source(0,num_vertices(topology.g)-1),
+		dest(0,num_vertices(topology.g)-2),
+		bandwidth(job.params.at("bwmin"),job.params.at("bwmax"))
 {}
 
-const StatCounter Simulation::run(const JobIterator::job_t &job) {
-	auto provision=ProvisioningSchemeFactory::getInstance().create(job.algname,job.params);
-	unsigned long itersDiscard=job.params.at("discard");
-	StatCounter count(itersDiscard);
-	if(!provision) return count;
-	unsigned long itersTotal=job.params.at("iters");
-	unsigned int load=job.params.at("load");
-	boost::random::taus88 rng(0);
-	boost::random::exponential_distribution<> requestTimeGen(1.0/AVG_INTARRIVAL);
-	boost::random::exponential_distribution<> holdingTimeGen(1.0/(AVG_INTARRIVAL*load));
-	boost::random::uniform_int_distribution<size_t> sourceGen(0,num_vertices(topology.g)-1);
-	boost::random::uniform_int_distribution<size_t> destGen(0,num_vertices(topology.g)-2);
-	boost::random::uniform_int_distribution<unsigned int>bandwidthGen(
-			job.params.at("bwmin"), job.params.at("bwmax"));
-	unsigned long nextRequestTime=0;
-	unsigned long currentTime=0;
+/**
+ * Run a simulation starting from an empty network, or from the job's state
+ * in the library.
+ */
+template<specIndex_t numSlots>
+const StatCounter Simulation<numSlots>::run(const JobIterator::job_t &job) {
+	prepare(job);
+	if(library && !trace) return runWarm(job,false);
+	return simulate(job);
+}
 
+/**
+ * Run a series of jobs with the same number of slots and fibers, starting
+ * each one from the state that the previous one left behind. Only the
+ * first job starts from an empty network. The others discard "rediscard"
+ * requests (default: a tenth of "discard") to settle into the steady state
+ * of their own parameters. The random numbers continue from job to job.
+ * @return The statistics of each job, in the order of jobs.
+ */
+template<specIndex_t numSlots>
+std::vector<StatCounter> Simulation<numSlots>::runChain(const std::vector<JobIterator::job_t> &jobs) {
+	std::vector<StatCounter> results;
+	for(size_t i=0; i<jobs.size(); ++i) {
+		if(i==0) results.push_back(run(jobs[i]));
+		else if(library && !trace) results.push_back(runWarm(jobs[i],true));
+		else results.push_back(resume(jobs[i]));
+	}
+	return results;
+}
+
+/**
+ * Run a job on the current state, discarding "rediscard" requests instead
+ * of "discard". The number of counted requests stays the same.
+ */
+template<specIndex_t numSlots>
+const StatCounter Simulation<numSlots>::resume(const JobIterator::job_t &job) {
+	scratchpad.resetWeights();
+	return simulate(continuation(job));
+}
+
+/**
+ * A copy of job for a run that continues from a warm state, which discards
+ * "rediscard" requests (default: a tenth of "discard").
+ */
+template<specIndex_t numSlots>
+JobIterator::job_t Simulation<numSlots>::continuation(const JobIterator::job_t &job) {
+	auto rediscard=job.params.find("rediscard");
+	return shortenWarmup(job,rediscard==job.params.end()?
+			floor(job.params.at("discard")/10):rediscard->second);
+}
+
+/**
+ * A copy of job that discards the given number of requests instead of
+ * "discard" and counts as many requests as job.
+ */
+template<specIndex_t numSlots>
+JobIterator::job_t Simulation<numSlots>::shortenWarmup(const JobIterator::job_t &job, double discard) {
+	JobIterator::job_t shortened=job;
+	const double iters=job.params.at("iters"), oldDiscard=job.params.at("discard");
+	discard=std::min(discard,oldDiscard);
+	shortened.params["discard"]=discard;
+	shortened.params["iters"]=std::max(iters-oldDiscard,0.0)+discard;
+	return shortened;
+}
+
+/**
+ * Run a job from its state in the library without discarding anything.
+ * Without such a state, the job runs from the current state, which is
+ * either empty (see prepare()) or left by the previous job of a chain. In
+ * both cases, the final state is added to the library unless it already
+ * has one for the job.
+ */
+template<specIndex_t numSlots>
+const StatCounter Simulation<numSlots>::runWarm(const JobIterator::job_t &job, bool chained) {
+	WarmState w;
+	StatCounter result(0);
+	if(library->load(job,topology,w) && w.numSlots==numSlots && w.numFibers==state.getNumFibers()) {
+		restore(w);
+		result=simulate(shortenWarmup(job,0));
+	} else {
+		result=chained?resume(job):simulate(job);
+	}
+	if(!library->contains(job)) library->store(job,warmState());
+	return result;
+}
+
+/**
+ * The active connections and the simulation time.
+ */
+template<specIndex_t numSlots>
+WarmState Simulation<numSlots>::warmState() const {
+	WarmState w;
+	w.currentTime=currentTime;
+	w.nextRequestTime=nextRequestTime;
+	w.numFibers=state.getNumFibers();
+	w.numSlots=numSlots;
+	for(auto const &c:activeConnections->schedule())
+		w.connections.push_back(std::make_pair(c.first,*c.second));
+	return w;
+}
+
+/**
+ * Replace the network state and the active connections by those of w.
+ * The random number generator is left alone.
+ */
+template<specIndex_t numSlots>
+void Simulation<numSlots>::restore(const WarmState &w) {
+	scratchpad.resetWeights();
+	state.reset();
+	clearConnections();
+	for(auto const &c:w.connections) {
+		state.provision(c.second);
+		activeConnections->insert(c.first,c.second);
+	}
+	currentTime=w.currentTime;
+	nextRequestTime=w.nextRequestTime;
+}
+
+/**
+ * Empty the network for a new run.
+ * The links have as many fibers as the "fibers" parameter says (default 1).
+ */
+template<specIndex_t numSlots>
+void Simulation<numSlots>::prepare(const JobIterator::job_t &job) {
+	auto fibers=job.params.find("fibers");
+	const fiberIndex_t numFibers=fibers==job.params.end()?1:lrint(fibers->second);
+	if(numFibers!=state.getNumFibers())
+		state=NetworkState<numSlots>(topology,numFibers);
 	reset();
-	for(unsigned long numProvisionings=0; numProvisionings<itersTotal; ++numProvisionings) {
-		//terminate all connections that should have terminated by now
-		for(std::map<unsigned long, Provisioning>::iterator nextTerm=activeConnections.begin();
-				nextTerm!=activeConnections.end() && nextTerm->first<=nextRequestTime;
-				nextTerm=activeConnections.begin()) {
-			//a termination event is next.
-
-			//advance simulation time to the next instant
-			if(nextTerm->first!=currentTime) {
-				currentTime=nextTerm->first;
-				count.countNetworkState(topology,state,currentTime);
+	auto reps=job.params.find("reps");
+	if(reps!=job.params.end() && reps->second>1) rng.seed(replicationSeed(job));
+}
+
+/**
+ * The seed of a replicated job, derived from the job index and the
+ * replication number (splitmix64). Jobs without replications use seed 0.
+ */
+template<specIndex_t numSlots>
+uint32_t Simulation<numSlots>::replicationSeed(const JobIterator::job_t &job) {
+	return splitmix64(((uint64_t)job.index<<32)+job.replication);
+}
+
+/**
+ * Run a simulation that continues from a previously saved state.
+ * The random number generator also continues from the saved state, so
+ * different algorithms or parameters that are run from the same snapshot
+ * see the same requests.
+ */
+template<specIndex_t numSlots>
+const StatCounter Simulation<numSlots>::run(const JobIterator::job_t &job, const Snapshot &from) {
+	scratchpad.resetWeights();
+	state=from.state;
+	//connections() copies the queue before it is modified
+	activeConnections=std::const_pointer_cast<ConnectionQueue>(from.connections);
+	rng=from.rng;
+	currentTime=from.currentTime;
+	nextRequestTime=from.nextRequestTime;
+	traceReader=from.traceReader;
+	nextRecord=from.nextRecord;
+	traceValid=from.traceValid;
+	return simulate(job);
+}
+
+/**
+ * Run several jobs with the same number of slots and fibers from one warm
+ * state. The network is warmed up once, with the algorithm of the first job
+ * and for its "discard" requests, and saved as a Snapshot. Each job then
+ * continues from the snapshot and only discards "rediscard" requests
+ * (default: a tenth of "discard"), so all jobs see the same requests.
+ * @return The statistics of each job, in the order of jobs.
+ */
+template<specIndex_t numSlots>
+std::vector<StatCounter> Simulation<numSlots>::runForked(const std::vector<JobIterator::job_t> &jobs) {
+	prepare(jobs.front());
+	JobIterator::job_t warmup=jobs.front();
+	warmup.params["iters"]=warmup.params.at("discard");
+	simulate(warmup);
+	const Snapshot from=snapshot();
+	std::vector<StatCounter> results;
+	for(const auto &job:jobs) results.push_back(run(continuation(job),from));
+	return results;
+}
+
+/**
+ * Save the current state, i.e. the state at the end of the last run.
+ */
+template<specIndex_t numSlots>
+typename Simulation<numSlots>::Snapshot Simulation<numSlots>::snapshot() const {
+	return Snapshot(*this);
+}
+
+/**
+ * The main loop of a run. Each iteration processes the terminations up to
+ * the next request and then the request itself.
+ */
+template<specIndex_t numSlots>
+const StatCounter Simulation<numSlots>::simulate(const JobIterator::job_t &job) {
+	if(!begin(job)) return count;
+#ifdef PHASE_TIMERS
+	PhaseTimer::Run timing(count.getPhaseTicks());
+#endif
+	RequestGenerator gen(topology,job);
+	const unsigned long itersTotal=job.params.at("iters");
+	auto parallel=job.params.find("parallel");
+	if(parallel!=job.params.end() && parallel->second>1) {
+		simulateSpeculative(gen,itersTotal,lrint(parallel->second));
+		return end();
+	}
+	auto restart=job.params.find("restart");
+	if(restart!=job.params.end() && restart->second>=1 && !trace) {
+		simulateSplitting(gen,itersTotal);
+		return end();
+	}
+	while(numProvisionings<itersTotal && (!trace || traceValid) && !converged()) {
+		advance(nextRequestTime);
+		if(offer(nextRequest(gen))) admit(nextHoldingTime(gen));
+		endRequest();
+		nextArrival(gen);
+	}
+	return end();
+}
+
+/**
+ * The main loop of simulate() with speculative provisioning on numThreads
+ * threads. The next requests are guessed and provisioned in parallel on
+ * the current state, then the requests are processed in order as usual,
+ * taking the speculative result wherever it is still valid.
+ *
+ * The generator only draws a holding time for provisioned requests, so the
+ * guesses assume that all requests are provisioned. After a blocked
+ * request, the remaining guesses are dropped and new ones are made. The
+ * number of guesses is halved while less than half of them turn out to be
+ * valid, down to one per thread.
+ */
+template<specIndex_t numSlots>
+void Simulation<numSlots>::simulateSpeculative(RequestGenerator &gen, unsigned long itersTotal,
+		unsigned int numThreads) {
+	SpeculativeProvisioner<numSlots> speculation(topology,*job,numThreads);
+	std::vector<Request> requests;
+	const size_t maxWindow=numThreads*SPECULATION_DEPTH;
+	size_t window=maxWindow;
+	while(numProvisionings<itersTotal && (!trace || traceValid) && !converged()) {
+		guessRequests(gen,std::min<unsigned long>(window,itersTotal-numProvisionings),requests);
+		speculation.speculate(state,requests);
+		size_t used=0, valid=0;
+		for(size_t i=0; i<requests.size()
+				&& numProvisionings<itersTotal && (!trace || traceValid) && !converged(); ++i) {
+			advance(nextRequestTime);
+			const Request r=nextRequest(gen);
+			const Provisioning *p=speculation.result(i,state,r);
+			bool provisioned;
+			++used;
+			if(p) {
+				++valid;
+				offered=*p;
+				provisioned=placeOffered();
+			} else {
+				provisioned=offer(r);
 			}
+			if(provisioned) admit(nextHoldingTime(gen));
+			endRequest();
+			nextArrival(gen);
+			if(!provisioned && !trace) break;
+		}
+		//look less far ahead while most guesses are wasted
+		if(2*valid<used) window=std::max<size_t>(numThreads,window/2);
+		else window=std::min(maxWindow,2*window);
+	}
+}
+
+/**
+ * The main loop of simulate() with multilevel splitting (RESTART) on the
+ * maximum link utilization. Whenever the main trajectory enters a higher
+ * level, "rsplit"-1 retrials are started from the current state for each
+ * level entered, and each retrial splits again in the same way when it
+ * enters a level above its own. A retrial ends when the state falls below
+ * the threshold of the level it was started for. Since a trajectory on
+ * level l is one of rsplit^l expected ones, its blocked requests are
+ * counted with the weight rsplit^-l, which keeps the estimate unbiased
+ * while blocking at high utilization is observed much more often.
+ *
+ * The retrials run on separate Simulation objects and draw their own
+ * random numbers, so the main trajectory and all other statistics are the
+ * same as in a run without splitting. Only the requests after the discard
+ * phase are split.
+ */
+template<specIndex_t numSlots>
+void Simulation<numSlots>::simulateSplitting(RequestGenerator &gen, unsigned long itersTotal) {
+	const unsigned long discard=job->params.at("discard");
+	const unsigned long numRequests=itersTotal>discard?itersTotal-discard:0;
+	auto batchSize=job->params.find("batchsize");
+	count.enableSplitting(numRequests,batchSize!=job->params.end() && batchSize->second>0?
+			lrint(batchSize->second):(numRequests+SPLIT_BATCHES-1)/SPLIT_BATCHES);
+	SplitRun run(*job,count,numRequests);
+	//a retrial only splits on higher levels, so one Simulation per level is enough
+	Simulation *s=this;
+	for(size_t i=0; i<run.thresholds.size(); ++i) {
+		if(!s->retrials) s->retrials.reset(new Simulation(topology,nullptr,traffic));
+		s=s->retrials.get();
+		s->job=job;
+		s->provision=createScheme(*job);
+		s->failSample=0;
+	}
+	unsigned int level=0;
+	//no early stop with relci: the retrials of the last requests would be cut off
+	while(numProvisionings<itersTotal) {
+		advance(nextRequestTime);
+		const bool measured=numProvisionings>=discard;
+		if(measured)
+			level=split(gen,run,level,run.level(state.getMaxUtilization()),numProvisionings-discard);
+		if(offer(nextRequest(gen))) admit(nextHoldingTime(gen));
+		if(measured) count.countSplit(numProvisionings-discard,run.weights[level],offered,true);
+		endRequest();
+		nextArrival(gen);
+	}
+}
+
+/**
+ * Move a trajectory from its level to the level now. If that is higher,
+ * start the retrials for each level that was entered, from the current
+ * state.
+ * @return now
+ */
+template<specIndex_t numSlots>
+unsigned int Simulation<numSlots>::split(RequestGenerator &gen, SplitRun &run, unsigned int level,
+		unsigned int now, unsigned long request) {
+	for(unsigned int l=level+1; l<=now; ++l)
+		for(unsigned int i=1; i<run.factor; ++i)
+			retrials->retrial(*this,gen,run,l,now,request);
+	return now;
+}
+
+/**
+ * Run a retrial of the given level from the state of parent, which is on
+ * level now and about to process the given request.
+ */
+template<specIndex_t numSlots>
+void Simulation<numSlots>::retrial(const Simulation &parent, RequestGenerator &gen, SplitRun &run,
+		unsigned int start, unsigned int now, unsigned long request) {
+	scratchpad.resetWeights();
+	state=parent.state;
+	activeConnections=parent.activeConnections;
+	currentTime=parent.currentTime;
+	nextRequestTime=parent.nextRequestTime;
+	rng.seed(splitmix64(run.seed++));
+	//the versions of the copied state repeat those of earlier retrials, so their memo is stale
+	auto memo=job->params.find("memo");
+	if(memo!=job->params.end() && memo->second) provision=createScheme(*job);
+	//nothing is counted here except through run.count
+	count=StatCounter(std::numeric_limits<uint64_t>::max(),currentTime);
+	run.count.countRetrial();
+	for(unsigned int level=split(gen,run,start,now,request); ; ) {
+		if(offer(nextRequest(gen))) admit(nextHoldingTime(gen));
+		run.count.countSplit(request,run.weights[level],offered,false);
+		if(++request==run.numRequests) return;
+		nextArrival(gen);
+		advance(nextRequestTime);
+		now=run.level(state.getMaxUtilization());
+		if(now<start) return;
+		level=split(gen,run,level,now,request);
+	}
+}
+
+/**
+ * The levels from the parameters "restart" (the number of thresholds),
+ * "rfrom" (the lowest threshold, default 0.5) and "rsplit" (the number of
+ * trajectories that continue from each threshold crossing, default 4).
+ * The thresholds are spread evenly between rfrom and 1.
+ */
+template<specIndex_t numSlots>
+Simulation<numSlots>::SplitRun::SplitRun(const JobIterator::job_t &job, StatCounter &count,
+		unsigned long numRequests):
+		thresholds(),
+		factor(),
+		weights(1,1.0),
+		count(count),
+		numRequests(numRequests),
+		seed((uint64_t)replicationSeed(job)<<32)
+{
+	const unsigned int numLevels=lrint(job.params.at("restart"));
+	auto from=job.params.find("rfrom");
+	auto splitParam=job.params.find("rsplit");
+	const double lowest=from==job.params.end()?0.5:from->second;
+	factor=splitParam==job.params.end()?4:std::max(1L,lrint(splitParam->second));
+	for(unsigned int i=0; i<numLevels; ++i) {
+		thresholds.push_back(lowest+i*(1-lowest)/numLevels);
+		weights.push_back(weights.back()/factor);
+	}
+}
 
-			//update the network state with the removed connection
-			state.terminate(nextTerm->second);
+/**
+ * The number of thresholds that the importance has reached.
+ */
+template<specIndex_t numSlots>
+unsigned int Simulation<numSlots>::SplitRun::level(double importance) const {
+	return std::upper_bound(thresholds.begin(),thresholds.end(),importance)-thresholds.begin();
+}
+
+/**
+ * The next n requests, assuming that all of them will be provisioned.
+ * The generator and the trace position are left unchanged.
+ */
+template<specIndex_t numSlots>
+void Simulation<numSlots>::guessRequests(RequestGenerator &gen, size_t n, std::vector<Request> &requests) {
+	requests.clear();
+	if(trace) {
+		TraceReader reader=traceReader;
+		TraceRecord record=nextRecord;
+		for(bool valid=traceValid; valid && requests.size()<n; valid=reader.next(record))
+			requests.push_back(traceRequest(record));
+	} else {
+		const boost::random::taus88 saved=rng;
+		while(requests.size()<n) {
+			requests.push_back(nextRequest(gen));
+			gen.holdingTime(rng);
+			gen.requestTime(rng);
+		}
+		rng=saved;
+	}
+}
+
+/**
+ * Run several jobs side by side on one request stream. The requests are
+ * generated (or read from the trace) once, from the parameters of the first
+ * job, and offered to every job in turn, so the jobs must agree on "iters",
+ * "load", "bwmin", "bwmax" and "discard". Each job has its own network
+ * state. Unlike in run(), the holding time is drawn for every request, so
+ * that all jobs see the same holding times.
+ *
+ * The k-shortest paths that a job computes on the unmodified link lengths
+ * are kept until the next request, so the other jobs do not have to
+ * compute them again. The blocking of each job is compared with that of
+ * the first job with a known algorithm, see StatCounter::countPaired().
+ * @return The statistics of each job, in the order of jobs.
+ */
+template<specIndex_t numSlots>
+std::vector<StatCounter> Simulation<numSlots>::runLockstep(const std::vector<JobIterator::job_t> &jobs) {
+	while(lanes.size()+1<jobs.size()) lanes.emplace_back(new Simulation(topology));
+	std::vector<Simulation*> sims(1,this);
+	for(size_t i=0; i+1<jobs.size(); ++i) sims.push_back(lanes[i].get());
+	NetworkGraph::PathCache paths;
+	std::vector<Simulation*> active;
+	for(size_t i=0; i<jobs.size(); ++i) {
+		sims[i]->prepare(jobs[i]);
+		if(sims[i]->begin(jobs[i])) {
+			sims[i]->count.enablePaired();
+			sims[i]->scratchpad.pathCache=&paths;
+			active.push_back(sims[i]);
+		}
+	}
+	RequestGenerator gen(topology,jobs.front());
+	const unsigned long itersTotal=jobs.front().params.at("iters");
+	std::vector<bool> blocked(active.size());
+	for(unsigned long i=0; i<itersTotal && (!trace || traceValid) && !active.empty()
+			&& !std::all_of(active.begin(),active.end(),[](Simulation *s){return s->converged();}); ++i) {
+		const Request r=nextRequest(gen);
+		const simtime_t holding=trace?nextRecord.holding:lrint(gen.holdingTime(rng));
+		for(size_t l=0; l<active.size(); ++l) {
+			Simulation &s=*active[l];
+			s.advance(nextRequestTime);
+			blocked[l]=!s.offer(r);
+			if(!blocked[l]) s.admit(holding);
+			s.endRequest();
+		}
+		for(size_t l=0; l<active.size(); ++l)
+			active[l]->count.countPaired(blocked[l],blocked.front(),r.bandwidth);
+		if(trace) readNextRecord();
+		else nextRequestTime+=lrint(gen.requestTime(rng));
+	}
+	std::vector<StatCounter> results;
+	for(size_t i=0; i<jobs.size(); ++i) {
+		sims[i]->scratchpad.pathCache=nullptr;
+		results.push_back(sims[i]->provision?sims[i]->end():sims[i]->count);
+	}
+	return results;
+}
 
-			count.countTermination(nextTerm->second);
+/**
+ * Set up the scheme and the statistics of a new run.
+ * @return false if the algorithm is unknown and there is nothing to run.
+ */
+template<specIndex_t numSlots>
+bool Simulation<numSlots>::begin(const JobIterator::job_t &job) {
+	this->job=&job;
+	provision=createScheme(job);
+	count=StatCounter(job.params.at("discard"),currentTime);
+	if(!provision) return false;
+	numProvisionings=0;
+	auto mser=job.params.find("mser");
+	if(mser!=job.params.end() && mser->second>0)
+		count.enableWarmupDetection(lrint(mser->second));
+	auto batchSize=job.params.find("batchsize");
+	if(batchSize!=job.params.end() && batchSize->second>0)
+		count.enableBatches(lrint(batchSize->second));
+	auto relciParam=job.params.find("relci");
+	relci=relciParam==job.params.end()?0:relciParam->second;
+	checkedSamples=0;
+	precise=false;
+	failSample=0;
+	auto failSampleParam=job.params.find("failsample");
+	if(failSampleParam!=job.params.end()) failSample=lrint(failSampleParam->second);
+	if(failSample) {
+		failures.rebuild(*activeConnections);
+		count.enableSurvivability();
+	}
+	//check a sample of the network state every "check" events
+	auto check=job.params.find("check");
+	auto checkBudget=job.params.find("checkbudget");
+	checker.start(check==job.params.end()?0:lrint(check->second),
+			checkBudget==job.params.end()?0.01:checkBudget->second);
+	countMemory(memStart);
+	connBytes=memStart.connections;
+	peakConnBytes=connBytes;
+	return true;
+}
 
-			//remove the connection from the list
-			activeConnections.erase(nextTerm);
+/**
+ * The heuristic of a job, wrapped in a MemoProvisioning if "memo" is set.
+ * @return nullptr if the algorithm is unknown.
+ */
+template<specIndex_t numSlots>
+std::unique_ptr<ProvisioningScheme<numSlots> > Simulation<numSlots>::createScheme(
+		const JobIterator::job_t &job) {
+	std::unique_ptr<ProvisioningScheme<numSlots> > p=
+			ProvisioningSchemeFactory::getInstance().create<numSlots>(job.algname,job.params);
+	auto memo=job.params.find("memo");
+	if(p && memo!=job.params.end() && memo->second)
+		p.reset(new MemoProvisioning<numSlots>(std::move(p)));
+	return p;
+}
 
+/**
+ * Terminate all connections that expire up to time t and advance the
+ * simulation time to t.
+ *
+ * The connections are handed to the NetworkState in batches, so that
+ * backup links shared by several of them are only rebuilt once. The
+ * metrics have to be counted at each instant, so a batch can only span
+ * more than one instant while the counter is still discarding.
+ */
+template<specIndex_t numSlots>
+void Simulation<numSlots>::advance(simtime_t t) {
+	ConnectionQueue &queue=connections();
+	while(!queue.empty() && queue.top().time<=t) {
+		//a termination event is next.
+		const simtime_t batchBegin=queue.top().time;
+		simtime_t batchLast=batchBegin;
+		expiring.clear();
+		expiringHandles.clear();
+		while(!queue.empty() && queue.top().time<=t
+				&& (queue.top().time==batchBegin || count.isDiscarding())) {
+			batchLast=queue.top().time;
+			expiringHandles.push_back(queue.top().conn);
+			queue.pop();
 		}
 
-		//advance simulation time to the next instant
-		if(nextRequestTime!=currentTime) {
-			currentTime=nextRequestTime;
+		//advance simulation time to the (last) instant of the batch
+		if(batchLast!=currentTime) {
+			currentTime=batchLast;
 			count.countNetworkState(topology,state,currentTime);
 		}
 
-		//a request event is next.
+		for(auto h:expiringHandles) {
+			const Provisioning &c=queue.get(h);
+			expiring.push_back(&c);
+			count.countTermination(c);
+			if(failSample) failures.remove(h,c);
+			connBytes-=StatCounter::Memory::connectionBytes(c.priPath.size(),c.bkpPath.size());
+		}
+
+		//update the network state with the removed connections
+		state.terminate(expiring);
+		if(!checker.event(state)) reportViolation();
+
+		//return the connections to the pool
+		for(auto h:expiringHandles) queue.release(h);
+	}
+
+	//advance simulation time to the next instant
+	if(t!=currentTime) {
+		currentTime=t;
+		count.countNetworkState(topology,state,currentTime);
+	}
+}
 
-		//Generate a random request
-		Request r;
-		nodeIndex_t sourceIndex=sourceGen(rng);
-		r.source=vertex(sourceIndex,topology.g);
-		nodeIndex_t destIndex=destGen(rng);
+/**
+ * Generate a random request or take it from the trace.
+ */
+template<specIndex_t numSlots>
+Request Simulation<numSlots>::nextRequest(RequestGenerator &gen) {
+	if(trace) return traceRequest(nextRecord);
+	Request r;
+	nodeIndex_t sourceIndex, destIndex;
+	unsigned int bandwidth;
+	if(traffic) {
+		if(!(*traffic)(rng,sourceIndex,destIndex,bandwidth)) bandwidth=gen.bandwidth(rng);
+	} else {
+		sourceIndex=gen.source(rng);
+		destIndex=gen.dest(rng);
 		if(destIndex>=sourceIndex) ++destIndex;
-		r.dest=vertex(destIndex,topology.g);
-		r.bandwidth=ceil((double)bandwidthGen(rng)/SLOT_WIDTH);
+		bandwidth=gen.bandwidth(rng);
+	}
+	r.source=vertex(sourceIndex,topology.g);
+	r.dest=vertex(destIndex,topology.g);
+	r.bandwidth=ceil((double)bandwidth/SLOT_WIDTH);
+	return r;
+}
 
-		//Run the provisioning algorithm
-		Provisioning p=(*provision)(topology,state,scratchpad,r);
+template<specIndex_t numSlots>
+Request Simulation<numSlots>::traceRequest(const TraceRecord &t) const {
+	Request r;
+	r.source=vertex(t.source,topology.g);
+	r.dest=vertex(t.dest,topology.g);
+	r.bandwidth=ceil((double)t.bandwidth/SLOT_WIDTH);
+	return r;
+}
 
-		count.countProvisioning(p);
+/**
+ * The holding time of the current request. The generator only draws it for
+ * provisioned connections.
+ */
+template<specIndex_t numSlots>
+simtime_t Simulation<numSlots>::nextHoldingTime(RequestGenerator &gen) {
+	return trace?nextRecord.holding:lrint(gen.holdingTime(rng));
+}
+
+/**
+ * Decide the time of the next request.
+ */
+template<specIndex_t numSlots>
+void Simulation<numSlots>::nextArrival(RequestGenerator &gen) {
+	if(trace) readNextRecord();
+	else nextRequestTime=currentTime+lrint(gen.requestTime(rng));
+}
+
+/**
+ * Run the provisioning algorithm and update the network state with the
+ * new connection, if there is one.
+ * @return true if the request was provisioned; it must then be admit()ted.
+ */
+template<specIndex_t numSlots>
+bool Simulation<numSlots>::offer(const Request &r) {
+	offered=(*provision)(topology,state,scratchpad,r);
+	return placeOffered();
+}
 
-		if(p.state==Provisioning::SUCCESS) {
-			//update the network state with the new connection
-			state.provision(p);
+/**
+ * Count the result in offered and, if it is a new connection, add it to
+ * the network state.
+ */
+template<specIndex_t numSlots>
+bool Simulation<numSlots>::placeOffered() {
+	count.countProvisioning(offered);
+	if(offered.state!=Provisioning::SUCCESS) return false;
+	state.provision(offered);
+	if(!checker.event(state)) reportViolation();
+	return true;
+}
 
-			//Add the connection to the active connection list with an expiry time
-			activeConnections.insert(std::pair<const unsigned long, Provisioning>(
-					currentTime+lrint(holdingTimeGen(rng)),p));
+/**
+ * Add the connection of the last offer() to the active connections.
+ */
+template<specIndex_t numSlots>
+void Simulation<numSlots>::admit(simtime_t holding) {
+	ConnectionQueue &queue=connections();
+	const ConnectionQueue::Handle h=queue.insert(currentTime+holding,offered);
+	const Provisioning &c=queue.get(h);
+	if(failSample) failures.add(h,c);
+	connBytes+=StatCounter::Memory::connectionBytes(c.priPath.size(),c.bkpPath.size());
+	peakConnBytes=std::max(peakConnBytes,connBytes);
 
 #ifdef DEBUG
-			if(count.getProvisioned()%100==1) state.sanityCheck(activeConnections);
+	if(count.getProvisioned()%100==1) state.sanityCheck(*activeConnections);
 #endif
-		}
+}
+
+template<specIndex_t numSlots>
+void Simulation<numSlots>::endRequest() {
+	++numProvisionings;
+	//the counter would ignore the result while discarding
+	if(failSample && numProvisionings%failSample==0 && !count.isDiscarding())
+		count.countSurvivability(failures.analyze(*activeConnections));
+}
 
-		//decide the time for the next request
-		nextRequestTime=currentTime+lrint(requestTimeGen(rng));
+/**
+ * True if the batch means already estimate BP as precisely as "relci" asks.
+ * The precision only changes when a batch completes, so it is only
+ * evaluated then.
+ */
+template<specIndex_t numSlots>
+bool Simulation<numSlots>::converged() {
+	if(relci<=0) return false;
+	if(count.getSamples().n!=checkedSamples) {
+		checkedSamples=count.getSamples().n;
+		precise=count.isPrecise(relci);
 	}
+	return precise;
+}
+
+template<specIndex_t numSlots>
+const StatCounter Simulation<numSlots>::end() {
+#ifdef PHASE_TIMERS
+	PhaseTimer::flush();
+#endif
+	count.endWarmup();
+	StatCounter::Memory memPeak;
+	countMemory(memPeak);
+	memPeak.connections=peakConnBytes;
+	count.countMemory(memStart,memPeak);
 	return count;
 }
 
-void Simulation::reset() {
+/**
+ * The memory that this Simulation currently holds.
+ */
+template<specIndex_t numSlots>
+void Simulation<numSlots>::countMemory(StatCounter::Memory &m) const {
+	state.countMemory(m);
+	m.dijkstra=NetworkGraph::DijkstraData::memoryUsage(
+			num_edges(topology.g),num_vertices(topology.g));
+	m.connections=0;
+	for(auto const c:activeConnections->ordered())
+		m.connections+=StatCounter::Memory::connectionBytes(
+				c->priPath.size(),c->bkpPath.size());
+	m.failures=failures.memoryUsage();
+}
+
+/**
+ * Estimate the memory of a run before it is started.
+ * The number of active connections is taken from the load in Erlang,
+ * as if nothing was blocked, with primaries of avgHops links and backups
+ * twice as long.
+ */
+template<specIndex_t numSlots>
+StatCounter::Memory Simulation<numSlots>::estimateMemory(const NetworkGraph &topology,
+		const JobIterator::job_t &job, double avgHops) {
+	const linkIndex_t numLinks=num_edges(topology.g);
+	auto fibers=job.params.find("fibers");
+	StatCounter::Memory m;
+	NetworkState<numSlots>::estimateMemory(numLinks,num_vertices(topology.g),
+			fibers==job.params.end()?1:lrint(fibers->second),m);
+	m.dijkstra=NetworkGraph::DijkstraData::memoryUsage(numLinks,num_vertices(topology.g));
+	const double load=job.params.at("load");
+	const size_t priHops=ceil(avgHops), bkpHops=ceil(2*avgHops);
+	m.connections=load*StatCounter::Memory::connectionBytes(priHops,bkpHops);
+	auto failSample=job.params.find("failsample");
+	if(failSample!=job.params.end() && failSample->second)
+		m.failures=2*numLinks*sizeof(std::vector<ConnectionQueue::Handle>)
+			+load*(priHops+bkpHops)*sizeof(ConnectionQueue::Handle);
+	return m;
+}
+
+/**
+ * Print where the InvariantChecker found the first inconsistency of this run.
+ */
+template<specIndex_t numSlots>
+void Simulation<numSlots>::reportViolation() const {
+	const linkIndex_t numLinks=boost::num_edges(topology.g);
+	std::ostringstream msg;
+	msg<<"Inconsistent network state in "<<job->algname
+		<<" at event "<<checker.getFailedEvent()<<" (request "<<numProvisionings
+		<<", time "<<currentTime<<"): link "<<checker.getFailedLink()%numLinks
+		<<", fiber "<<checker.getFailedLink()/numLinks<<'\n';
+	std::cerr<<msg.str();
+}
+
+template<specIndex_t numSlots>
+void Simulation<numSlots>::reset() {
 	scratchpad.resetWeights();
 	state.reset();
-	activeConnections.clear();
+	clearConnections();
+	rng.seed(0);
+	currentTime=0;
+	nextRequestTime=0;
+	if(trace) {
+		traceReader=TraceReader(*trace);
+		readNextRecord();
+	}
+}
+
+/**
+ * The active connections for modification. A queue that is still shared
+ * with a Snapshot or another Simulation is copied first.
+ */
+template<specIndex_t numSlots>
+ConnectionQueue &Simulation<numSlots>::connections() {
+	if(activeConnections.use_count()>1)
+		activeConnections=std::make_shared<ConnectionQueue>(*activeConnections);
+	return *activeConnections;
+}
+
+/**
+ * Empty the active connections without copying them if they are shared.
+ */
+template<specIndex_t numSlots>
+void Simulation<numSlots>::clearConnections() {
+	if(activeConnections.use_count()>1) activeConnections=std::make_shared<ConnectionQueue>();
+	else activeConnections->clear();
+}
+
+/**
+ * Advance to the next request of the trace. At the end of the trace,
+ * traceValid becomes false and the run stops.
+ */
+template<specIndex_t numSlots>
+void Simulation<numSlots>::readNextRecord() {
+	traceValid=traceReader.next(nextRecord);
+	if(traceValid) nextRequestTime=nextRecord.arrival;
+}
+
+template<specIndex_t numSlots>
+Simulation<numSlots>::Snapshot::Snapshot(const Simulation &s):
+		state(s.state),
+		connections(s.activeConnections),
+		currentTime(s.currentTime),
+		nextRequestTime(s.nextRequestTime),
+		rng(s.rng),
+		traceReader(s.traceReader),
+		nextRecord(s.nextRecord),
+		traceValid(s.traceValid)
+{}
+
+#define INSTANTIATE_SIMULATION(n) template class Simulation<n>;
+FOR_EACH_NUM_SLOTS(INSTANTIATE_SIMULATION)
+
+SimulationDispatcher::SimulationDispatcher(const NetworkGraph& topology, const TraceFile *trace,
+		const TrafficMatrix *traffic, const WarmStateLibrary *library):
+	topology(topology),
+	trace(trace),
+	traffic(traffic),
+	library(library)
+{}
+
+SimulationDispatcher::~SimulationDispatcher() {
+}
+
+/**
+ * Run a job on the Simulation for its number of slots.
+ * Jobs with an unsupported number of slots produce empty statistics, like
+ * jobs with an unknown algorithm name.
+ */
+const StatCounter SimulationDispatcher::run(const JobIterator::job_t &job) {
+	switch(getNumSlots(job.params)) {
+#define RUN_SIMULATION(n) \
+	case n: \
+		if(!sim##n) sim##n.reset(new Simulation<n>(topology,trace,traffic,library)); \
+		return sim##n->run(job);
+	FOR_EACH_NUM_SLOTS(RUN_SIMULATION)
+#undef RUN_SIMULATION
+	default:
+		return StatCounter(job.params.at("discard"));
+	}
+}
+
+/**
+ * Run a group of jobs in lock-step on the Simulation for the number of
+ * slots of the first job. All jobs must ask for the same number of slots.
+ */
+std::vector<StatCounter> SimulationDispatcher::runLockstep(const std::vector<JobIterator::job_t> &jobs) {
+	switch(getNumSlots(jobs.front().params)) {
+#define RUN_LOCKSTEP(n) \
+	case n: \
+		if(!sim##n) sim##n.reset(new Simulation<n>(topology,trace,traffic,library)); \
+		return sim##n->runLockstep(jobs);
+	FOR_EACH_NUM_SLOTS(RUN_LOCKSTEP)
+#undef RUN_LOCKSTEP
+	default:
+		return std::vector<StatCounter>(jobs.size(),StatCounter(jobs.front().params.at("discard")));
+	}
+}
+
+/**
+ * Run a chain of jobs with the same number of slots, see Simulation::runChain().
+ */
+std::vector<StatCounter> SimulationDispatcher::runChain(const std::vector<JobIterator::job_t> &jobs) {
+	switch(getNumSlots(jobs.front().params)) {
+#define RUN_CHAIN(n) \
+	case n: \
+		if(!sim##n) sim##n.reset(new Simulation<n>(topology,trace,traffic,library)); \
+		return sim##n->runChain(jobs);
+	FOR_EACH_NUM_SLOTS(RUN_CHAIN)
+#undef RUN_CHAIN
+	default:
+		return std::vector<StatCounter>(jobs.size(),StatCounter(jobs.front().params.at("discard")));
+	}
+}
+
+/**
+ * Run a group of jobs from one warm state, see Simulation::runForked().
+ * All jobs must ask for the same number of slots.
+ */
+std::vector<StatCounter> SimulationDispatcher::runForked(const std::vector<JobIterator::job_t> &jobs) {
+	switch(getNumSlots(jobs.front().params)) {
+#define RUN_FORKED(n) \
+	case n: \
+		if(!sim##n) sim##n.reset(new Simulation<n>(topology,trace,traffic,library)); \
+		return sim##n->runForked(jobs);
+	FOR_EACH_NUM_SLOTS(RUN_FORKED)
+#undef RUN_FORKED
+	default:
+		return std::vector<StatCounter>(jobs.size(),StatCounter(jobs.front().params.at("discard")));
+	}
+}
+
+/**
+ * Estimate the memory of a job on the Simulation for its number of slots.
+ * See Simulation::estimateMemory().
+ */
+StatCounter::Memory SimulationDispatcher::estimateMemory(const NetworkGraph &topology,
+		const JobIterator::job_t &job, double avgHops) {
+	switch(getNumSlots(job.params)) {
+#define ESTIMATE_SIMULATION(n) \
+	case n: \
+		return Simulation<n>::estimateMemory(topology,job,avgHops);
+	FOR_EACH_NUM_SLOTS(ESTIMATE_SIMULATION)
+#undef ESTIMATE_SIMULATION
+	default:
+		return StatCounter::Memory();
+	}
+}
+
+/**
+ * The number of slots requested by a parameter set.
+ * @return The value of the "slots" parameter, or DEFAULT_NUM_SLOTS if there is none.
+ */
+specIndex_t SimulationDispatcher::getNumSlots(const ProvisioningSchemeBase::ParameterSet &params) {
+	auto it=params.find("slots");
+	if(it==params.end()) return DEFAULT_NUM_SLOTS;
+	return lrint(it->second);
 }
@@ -23,15 +23,25 @@
 #ifndef SIMULATION_H_
 #define SIMULATION_H_
 
+#include <boost/random/exponential_distribution.hpp>
+#include <boost/random/taus88.hpp>
+#include <boost/random/uniform_int_distribution.hpp>
 #include <map>
+#include <memory>
+#include <vector>
 
+#include "ConnectionQueue.h"
+#include "FailureAnalysis.h"
+#include "InvariantChecker.h"
 #include "JobIterator.h"
 #include "NetworkGraph.h"
 #include "NetworkState.h"
+#include "provisioning_schemes/ProvisioningScheme.h"
+#include "RequestTrace.h"
 #include "SimulationMsgs.h"
-
-class ProvisioningScheme;
-class StatCounter;
+#include "StatCounter.h"
+#include "TrafficMatrix.h"
+#include "WarmStateLibrary.h"
 
 /**
  * \brief Implementation of the event-driven simulation main loop.
@@ -40,18 +50,211 @@ class StatCounter;
  * The Simulation class maintains the random number generator and active
  * connection list. To measure performance metrics, the simulation uses a
  * StatCounter object.
+ *
+ * With the "batchsize" parameter, the blocking probabilities are also
+ * estimated from batch means, and with "relci" the run stops early once
+ * their confidence interval is narrow enough. Replications of a job (see
+ * JobIterator::job_t) draw their requests from distinct seeds.
+ *
+ * With "parallel" set to more than one thread, upcoming requests are
+ * provisioned speculatively by a SpeculativeProvisioner. The results are
+ * the same as those of a serial run.
+ *
+ * With "restart", rare blocking is estimated by multilevel splitting, see
+ * simulateSplitting(). This needs generated requests and is ignored when
+ * replaying a trace.
+ *
+ * Instead of generating the requests, a Simulation can replay them from a
+ * TraceFile. A run then ends after "iters" requests or at the end of the
+ * trace, and the "load", "bwmin" and "bwmax" parameters are not used.
+ * Generated requests are spread uniformly over all pairs of nodes, unless
+ * a TrafficMatrix is given.
+ *
+ * The state at the end of a run can be saved as a Snapshot and used as the
+ * starting point of any number of later runs. runForked() runs several jobs
+ * from one such state, runChain() runs a series of jobs, each from the state
+ * that the previous one left behind, and a WarmStateLibrary keeps such
+ * states on disk for later invocations.
+ *
+ * runLockstep() runs several jobs side by side on the same requests, each
+ * with its own NetworkState, and compares their blocking request by request.
+ *
+ * Simulations are compiled for each number of slots in FOR_EACH_NUM_SLOTS;
+ * use a SimulationDispatcher to select one at run time.
  */
+template<specIndex_t numSlots>
 class Simulation {
 public:
-	Simulation(const NetworkGraph &topology);
+	/**
+	 * \brief A frozen copy of a simulation's state at the end of a run.
+	 *
+	 * Creating a Snapshot and continuing from it is cheap, because the
+	 * NetworkState copy shares all links with the original until they are
+	 * modified, and the active connections are shared until the first
+	 * termination or admission. A Snapshot is never modified after it was created, so the
+	 * same Snapshot can be used by several Simulation objects in different
+	 * threads at the same time.
+	 */
+	class Snapshot {
+	public:
+		const NetworkState<numSlots> state;
+		const std::shared_ptr<const ConnectionQueue> connections;
+		const unsigned long currentTime, nextRequestTime;
+		const boost::random::taus88 rng;
+		const TraceReader traceReader;
+		const TraceRecord nextRecord;
+		const bool traceValid;
+	private:
+		friend class Simulation;
+		Snapshot(const Simulation &s);
+	};
+	Simulation(const NetworkGraph &topology, const TraceFile *trace=nullptr,
+			const TrafficMatrix *traffic=nullptr, const WarmStateLibrary *library=nullptr);
 	const StatCounter run(const JobIterator::job_t &job);
+	const StatCounter run(const JobIterator::job_t &job, const Snapshot &from);
+	std::vector<StatCounter> runLockstep(const std::vector<JobIterator::job_t> &jobs);
+	std::vector<StatCounter> runChain(const std::vector<JobIterator::job_t> &jobs);
+	std::vector<StatCounter> runForked(const std::vector<JobIterator::job_t> &jobs);
+	Snapshot snapshot() const;
 	~Simulation();
 	void reset();
+	static StatCounter::Memory estimateMemory(const NetworkGraph &topology,
+			const JobIterator::job_t &job, double avgHops);
+	static uint32_t replicationSeed(const JobIterator::job_t &job);
 private:
+	/**
+	 * \brief The distributions of the built-in request generator.
+	 */
+	struct RequestGenerator {
+		RequestGenerator(const NetworkGraph &topology, const JobIterator::job_t &job);
+		boost::random::exponential_distribution<> requestTime, holdingTime;
+		boost::random::uniform_int_distribution<size_t> source, dest;
+		boost::random::uniform_int_distribution<unsigned int> bandwidth;
+	};
+	void prepare(const JobIterator::job_t &job);
+	const StatCounter simulate(const JobIterator::job_t &job);
+	void simulateSpeculative(RequestGenerator &gen, unsigned long itersTotal, unsigned int numThreads);
+	/**
+	 * \brief The levels and the shared counters of a splitting run, see simulateSplitting().
+	 */
+	struct SplitRun {
+		SplitRun(const JobIterator::job_t &job, StatCounter &count, unsigned long numRequests);
+		/// Increasing thresholds of the maximum link utilization.
+		std::vector<double> thresholds;
+		unsigned int factor;
+		/// The weight of a request on each level, factor^-level.
+		std::vector<double> weights;
+		/// The counter of the main trajectory, which counts for all trajectories.
+		StatCounter &count;
+		unsigned long numRequests;
+		/// Retrials seed their generators from consecutive values of this.
+		uint64_t seed;
+		unsigned int level(double importance) const;
+	};
+	void simulateSplitting(RequestGenerator &gen, unsigned long itersTotal);
+	unsigned int split(RequestGenerator &gen, SplitRun &run, unsigned int level,
+			unsigned int now, unsigned long request);
+	void retrial(const Simulation &parent, RequestGenerator &gen, SplitRun &run,
+			unsigned int start, unsigned int now, unsigned long request);
+	void guessRequests(RequestGenerator &gen, size_t n, std::vector<Request> &requests);
+	//the steps of a run, see simulate()
+	const StatCounter resume(const JobIterator::job_t &job);
+	const StatCounter runWarm(const JobIterator::job_t &job, bool chained);
+	JobIterator::job_t shortenWarmup(const JobIterator::job_t &job, double discard);
+	JobIterator::job_t continuation(const JobIterator::job_t &job);
+	WarmState warmState() const;
+	void restore(const WarmState &w);
+	static std::unique_ptr<ProvisioningScheme<numSlots> > createScheme(const JobIterator::job_t &job);
+	bool begin(const JobIterator::job_t &job);
+	void advance(simtime_t t);
+	Request nextRequest(RequestGenerator &gen);
+	Request traceRequest(const TraceRecord &r) const;
+	simtime_t nextHoldingTime(RequestGenerator &gen);
+	void nextArrival(RequestGenerator &gen);
+	bool offer(const Request &r);
+	bool placeOffered();
+	void admit(simtime_t holding);
+	void endRequest();
+	bool converged();
+	const StatCounter end();
+	void countMemory(StatCounter::Memory &m) const;
+	void reportViolation() const;
 	const NetworkGraph& topology;
 	const NetworkGraph::DijkstraData scratchpad;
-	NetworkState state;
-	std::multimap<unsigned long, Provisioning> activeConnections;
+	NetworkState<numSlots> state;
+	/// Shared with the snapshots of this run and the one it continues from; see connections().
+	std::shared_ptr<ConnectionQueue> activeConnections;
+	ConnectionQueue &connections();
+	void clearConnections();
+	/// The batch of connections that is currently being terminated.
+	std::vector<const Provisioning*> expiring;
+	std::vector<ConnectionQueue::Handle> expiringHandles;
+	FailureAnalysis<numSlots> failures;
+	InvariantChecker<numSlots> checker;
+	boost::random::taus88 rng;
+	unsigned long currentTime, nextRequestTime;
+	/// If not null, the requests are read from this trace instead of being generated.
+	const TraceFile *trace;
+	TraceReader traceReader;
+	/// The request at nextRequestTime, if traceValid.
+	TraceRecord nextRecord;
+	bool traceValid;
+	void readNextRecord();
+	/// If not null, the sources, destinations and bandwidths are drawn from this matrix.
+	const TrafficMatrix *traffic;
+	/// If not null, runs start from the steady states in this library and add to it.
+	const WarmStateLibrary *library;
+
+	//the state of the current run
+	const JobIterator::job_t *job;
+	std::unique_ptr<ProvisioningScheme<numSlots> > provision;
+	StatCounter count;
+	/// Sample the survivability under single link failures every failSample requests.
+	unsigned long failSample;
+	/// Stop the run once the relative confidence half-width of BP is this small, or 0.
+	double relci;
+	/// The number of batches when converged() last evaluated the precision, and its result.
+	uint64_t checkedSamples;
+	bool precise;
+	unsigned long numProvisionings;
+	/// The result of the last offer().
+	Provisioning offered;
+	/// The memory at the start of the run; the connections are tracked to find the peak.
+	StatCounter::Memory memStart;
+	uint64_t connBytes, peakConnBytes;
+	/// The other jobs of runLockstep(). They only use their own state, never their generator.
+	std::vector<std::unique_ptr<Simulation> > lanes;
+	/// Runs the retrials that this Simulation starts in a splitting run.
+	std::unique_ptr<Simulation> retrials;
+};
+
+/**
+ * \brief Runs each job on a Simulation compiled for the number of slots it asks for.
+ *
+ * The number of slots is taken from the "slots" parameter of the job and
+ * defaults to DEFAULT_NUM_SLOTS. A Simulation for each number of slots is
+ * only created when a job first needs it.
+ */
+class SimulationDispatcher {
+public:
+	SimulationDispatcher(const NetworkGraph &topology, const TraceFile *trace=nullptr,
+			const TrafficMatrix *traffic=nullptr, const WarmStateLibrary *library=nullptr);
+	~SimulationDispatcher();
+	const StatCounter run(const JobIterator::job_t &job);
+	std::vector<StatCounter> runLockstep(const std::vector<JobIterator::job_t> &jobs);
+	std::vector<StatCounter> runChain(const std::vector<JobIterator::job_t> &jobs);
+	std::vector<StatCounter> runForked(const std::vector<JobIterator::job_t> &jobs);
+	static StatCounter::Memory estimateMemory(const NetworkGraph &topology,
+			const JobIterator::job_t &job, double avgHops);
+	static specIndex_t getNumSlots(const ProvisioningSchemeBase::ParameterSet &params);
+private:
+	const NetworkGraph &topology;
+	const TraceFile *trace;
+	const TrafficMatrix *traffic;
+	const WarmStateLibrary *library;
+#define DECLARE_SIMULATION(n) std::unique_ptr<Simulation<n> > sim##n;
+	FOR_EACH_NUM_SLOTS(DECLARE_SIMULATION)
+#undef DECLARE_SIMULATION
 };
 
 #endif /* SIMULATION_H_ */
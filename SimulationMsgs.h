@@ -52,6 +52,9 @@ struct Provisioning{
 	specIndex_t bkpSpecBegin, bkpSpecEnd;
 	modulation_t bkpMod;
 
+	/// The fibers that carry the primary and the backup on all links of their paths.
+	fiberIndex_t priFiber=0, bkpFiber=0;
+
 	bandwidth_t bandwidth;
 
 	/**
@@ -0,0 +1,163 @@
+/**
+ * @file SpeculativeProvisioner.cpp
+ *
+ */
+
+/*
+ * This file is part of eonsim.
+ *
+ * eonsim is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * eonsim is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with eonsim.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#include "SpeculativeProvisioner.h"
+
+#include <algorithm>
+
+#include "provisioning_schemes/ProvisioningSchemeFactory.h"
+
+template<specIndex_t numSlots>
+SpeculativeProvisioner<numSlots>::Lane::Lane(const NetworkGraph &topology,
+		const JobIterator::job_t &job):
+		scheme(ProvisioningSchemeFactory::getInstance().create<numSlots>(job.algname,job.params)),
+		data(topology),
+		reads()
+{}
+
+/**
+ * @param numThreads The number of threads, including the calling one
+ */
+template<specIndex_t numSlots>
+SpeculativeProvisioner<numSlots>::SpeculativeProvisioner(const NetworkGraph &topology,
+		const JobIterator::job_t &job, unsigned int numThreads):
+		topology(topology),
+		lanes(),
+		specs(),
+		state(nullptr),
+		requests(nullptr),
+		next(0),
+		threads(),
+		mtx(),
+		cvStart(),
+		cvDone(),
+		generation(0),
+		finished(0),
+		stop(false)
+{
+	for(unsigned int i=0; i<std::max(1u,numThreads); ++i)
+		lanes.emplace_back(new Lane(topology,job));
+	for(size_t i=1; i<lanes.size(); ++i)
+		threads.emplace_back(&SpeculativeProvisioner::work,this,i);
+}
+
+template<specIndex_t numSlots>
+SpeculativeProvisioner<numSlots>::~SpeculativeProvisioner() {
+	{
+		std::unique_lock<std::mutex> lck(mtx);
+		stop=true;
+	}
+	cvStart.notify_all();
+	for(auto &t:threads) t.join();
+}
+
+/**
+ * Provision all requests against s in parallel and keep the results.
+ * Returns when every worker thread has finished this batch, so none of
+ * them touches the batch or the results afterwards.
+ */
+template<specIndex_t numSlots>
+void SpeculativeProvisioner<numSlots>::speculate(const NetworkState<numSlots> &s,
+		const std::vector<Request> &requests) {
+	{
+		std::unique_lock<std::mutex> lck(mtx);
+		if(specs.size()<requests.size()) specs.resize(requests.size());
+		state=&s;
+		this->requests=&requests;
+		next=0;
+		finished=0;
+		++generation;
+	}
+	cvStart.notify_all();
+	process(*lanes.front());
+	std::unique_lock<std::mutex> lck(mtx);
+	cvDone.wait(lck,[this]{return finished==threads.size();});
+}
+
+/**
+ * The result of the i-th request of the last speculate() call, if it is
+ * still valid for request r on the state s.
+ * @return nullptr if the request has to be provisioned again.
+ */
+template<specIndex_t numSlots>
+const Provisioning *SpeculativeProvisioner<numSlots>::result(size_t i,
+		const NetworkState<numSlots> &s, const Request &r) const {
+	const Speculation &sp=specs[i];
+	if(sp.request.source!=r.source || sp.request.dest!=r.dest || sp.request.bandwidth!=r.bandwidth)
+		return nullptr;
+	for(auto const &l:sp.links)
+		if(s.getLinkVersion(l.first)!=l.second) return nullptr;
+	for(auto const &n:sp.nodes)
+		if(s.getNodeVersion(n.first)!=n.second) return nullptr;
+	return &sp.result;
+}
+
+template<specIndex_t numSlots>
+void SpeculativeProvisioner<numSlots>::work(size_t lane) {
+	uint64_t seen=0;
+	while(true) {
+		{
+			std::unique_lock<std::mutex> lck(mtx);
+			cvStart.wait(lck,[this,seen]{return stop || generation!=seen;});
+			if(stop) return;
+			seen=generation;
+		}
+		process(*lanes[lane]);
+		{
+			std::unique_lock<std::mutex> lck(mtx);
+			++finished;
+		}
+		cvDone.notify_one();
+	}
+}
+
+/**
+ * Take requests of the current batch until none are left.
+ */
+template<specIndex_t numSlots>
+void SpeculativeProvisioner<numSlots>::process(Lane &lane) {
+	for(size_t i=next++; i<requests->size(); i=next++) {
+		Speculation &sp=specs[i];
+		sp.request=(*requests)[i];
+		lane.reads.links.clear();
+		lane.reads.nodes.clear();
+		state->trackReads(&lane.reads);
+		sp.result=(*lane.scheme)(topology,*state,lane.data,sp.request);
+		state->trackReads(0);
+
+		std::sort(lane.reads.links.begin(),lane.reads.links.end());
+		lane.reads.links.erase(std::unique(lane.reads.links.begin(),lane.reads.links.end()),
+				lane.reads.links.end());
+		std::sort(lane.reads.nodes.begin(),lane.reads.nodes.end());
+		lane.reads.nodes.erase(std::unique(lane.reads.nodes.begin(),lane.reads.nodes.end()),
+				lane.reads.nodes.end());
+		sp.links.clear();
+		for(linkIndex_t l:lane.reads.links)
+			sp.links.push_back(std::make_pair(l,state->getLinkVersion(l)));
+		sp.nodes.clear();
+		for(nodeIndex_t n:lane.reads.nodes)
+			sp.nodes.push_back(std::make_pair(n,state->getNodeVersion(n)));
+	}
+}
+
+#define INSTANTIATE_SPECULATIVEPROVISIONER(n) template class SpeculativeProvisioner<n>;
+FOR_EACH_NUM_SLOTS(INSTANTIATE_SPECULATIVEPROVISIONER)
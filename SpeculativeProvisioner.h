@@ -0,0 +1,106 @@
+/**
+ * @file SpeculativeProvisioner.h
+ *
+ */
+
+/*
+ * This file is part of eonsim.
+ *
+ * eonsim is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * eonsim is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with eonsim.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#ifndef SPECULATIVEPROVISIONER_H_
+#define SPECULATIVEPROVISIONER_H_
+
+#include <stddef.h>
+#include <atomic>
+#include <condition_variable>
+#include <cstdint>
+#include <memory>
+#include <mutex>
+#include <thread>
+#include <utility>
+#include <vector>
+
+#include "globaldef.h"
+#include "JobIterator.h"
+#include "NetworkGraph.h"
+#include "NetworkState.h"
+#include "provisioning_schemes/ProvisioningScheme.h"
+#include "SimulationMsgs.h"
+
+/**
+ * \brief Runs a heuristic for several upcoming requests in parallel.
+ *
+ * All requests of a batch are provisioned against the same NetworkState,
+ * which must not change while speculate() runs. Each result is stored with
+ * the versions of the links and nodes that the heuristic read (see
+ * NetworkState::trackReads()). When the simulation reaches a request, the
+ * result is only used if the request is the one that was guessed and none
+ * of these links and nodes has changed since, so it is the result that
+ * the heuristic would compute on the current state. Otherwise the request
+ * has to be provisioned again.
+ *
+ * Every thread has its own instance of the heuristic and its own
+ * DijkstraData. The heuristic must only read the NetworkState through its
+ * const member functions and must not keep state between requests.
+ * The calling thread takes part in the work.
+ */
+template<specIndex_t numSlots>
+class SpeculativeProvisioner {
+public:
+	SpeculativeProvisioner(const NetworkGraph &topology, const JobIterator::job_t &job,
+			unsigned int numThreads);
+	~SpeculativeProvisioner();
+	void speculate(const NetworkState<numSlots> &s, const std::vector<Request> &requests);
+	const Provisioning *result(size_t i, const NetworkState<numSlots> &s, const Request &r) const;
+private:
+	/**
+	 * \brief What a thread needs to run the heuristic.
+	 */
+	struct Lane {
+		Lane(const NetworkGraph &topology, const JobIterator::job_t &job);
+		std::unique_ptr<ProvisioningScheme<numSlots> > scheme;
+		NetworkGraph::DijkstraData data;
+		typename NetworkState<numSlots>::ReadSet reads;
+	};
+	/**
+	 * \brief The result for one request and the state it was computed from.
+	 */
+	struct Speculation {
+		Request request;
+		Provisioning result;
+		std::vector<std::pair<linkIndex_t, uint64_t> > links;
+		std::vector<std::pair<nodeIndex_t, uint64_t> > nodes;
+	};
+	const NetworkGraph &topology;
+	std::vector<std::unique_ptr<Lane> > lanes;
+	std::vector<Speculation> specs;
+	//the current batch, only changed while no thread is working on it
+	const NetworkState<numSlots> *state;
+	const std::vector<Request> *requests;
+	std::atomic<size_t> next;
+	std::vector<std::thread> threads;
+	std::mutex mtx;
+	std::condition_variable cvStart, cvDone;
+	uint64_t generation;
+	/// The number of worker threads that are done with the current generation.
+	unsigned int finished;
+	bool stop;
+	void work(size_t lane);
+	void process(Lane &lane);
+	SpeculativeProvisioner(const SpeculativeProvisioner &);
+};
+
+#endif /* SPECULATIVEPROVISIONER_H_ */
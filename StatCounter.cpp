@@ -23,12 +23,28 @@
 #include "StatCounter.h"
 
 #include <boost/format.hpp>
+#include <boost/math/distributions/students_t.hpp>
 #include <algorithm>
+#include <cmath>
+#include <limits>
+#include <string>
 
 #include "globaldef.h"
 #include "Simulation.h"
 
-StatCounter::StatCounter(const uint64_t discard) :
+namespace {
+/// MSER-5 groups the warm-up windows into batches of this many.
+const size_t mserBatch=5;
+/// The fewest batches before the truncation point is looked for.
+const size_t mserMinBatches=10;
+const size_t noTruncation=~(size_t)0;
+}
+
+/**
+ * @param discard Number of events to discard before counting starts
+ * @param startTime The simulation time at which the run starts
+ */
+StatCounter::StatCounter(const uint64_t discard, const uint64_t startTime) :
 	discard(discard),
 	nBlocked(),
 	nProvisioned(),
@@ -37,8 +53,33 @@ StatCounter::StatCounter(const uint64_t discard) :
 	bwProvisioned(),
 	bwTerminated(),
 	perf(),
-	simTime(),
-	discardedTime()
+	simTime(startTime),
+	discardedTime(discard?0:startTime),
+	survivabilityEnabled(false),
+	survivability(),
+	pairedEnabled(false),
+	paired(),
+	splittingEnabled(false),
+	splitting(),
+	batchSize(0),
+	batchRequests(0),
+	batchBlocked(0),
+	batchBw(0),
+	batchBwBlocked(0),
+	samplesEnabled(false),
+	samples(),
+	numReplications(0),
+	pooledTime(0),
+	warmupWindow(0),
+	warming(false),
+	checkpoints(),
+	truncation(0),
+	memoryCounted(false),
+	memoryStart(),
+	memoryPeak()
+#ifdef PHASE_TIMERS
+	,phaseTicks()
+#endif
 {}
 
 StatCounter::~StatCounter() {
@@ -61,6 +102,272 @@ void StatCounter::reset(const uint64_t discard) {
 	perf.reset();
 	simTime=0;
 	discardedTime=0;
+	survivability=Survivability();
+	paired=Paired();
+	splitting=Splitting();
+#ifdef PHASE_TIMERS
+	phaseTicks.fill(0);
+#endif
+	batchRequests=0;
+	batchBlocked=0;
+	batchBw=0;
+	batchBwBlocked=0;
+	samples=Samples();
+	numReplications=0;
+	pooledTime=0;
+	warming=false;
+	checkpoints.clear();
+	truncation=0;
+	memoryCounted=false;
+}
+
+/**
+ * Add the survivability columns to the output.
+ */
+void StatCounter::enableSurvivability() {
+	survivabilityEnabled=true;
+}
+
+/**
+ * Count the result of a failure analysis of the current network state.
+ * Like the other events, this is ignored during the discard phase.
+ */
+void StatCounter::countSurvivability(const Survivability &s) {
+	if(!discard)
+		survivability+=s;
+}
+
+/**
+ * Add the paired blocking difference columns to the output.
+ */
+void StatCounter::enablePaired() {
+	pairedEnabled=true;
+}
+
+/**
+ * Count whether the same request was blocked here and in the reference run.
+ * Like the other events, this is ignored during the discard phase.
+ */
+void StatCounter::countPaired(bool blocked, bool refBlocked, bandwidth_t bw) {
+	if(discard) return;
+	++paired.requests;
+	paired.bwTotal+=bw;
+	if(blocked && !refBlocked) {
+		++paired.onlyThis;
+		paired.bwOnlyThis+=bw;
+	} else if(refBlocked && !blocked) {
+		++paired.onlyRef;
+		paired.bwOnlyRef+=bw;
+	}
+}
+
+/**
+ * Add the splitting estimate columns to the output.
+ * @param numRequests The number of measured requests of the main trajectory
+ * @param batchSize Requests per batch
+ */
+void StatCounter::enableSplitting(uint64_t numRequests, uint64_t batchSize) {
+	splittingEnabled=true;
+	splitting.batchSize=std::max<uint64_t>(1,batchSize);
+	splitting.batches.assign((numRequests+splitting.batchSize-1)/splitting.batchSize,Splitting::Batch());
+}
+
+/**
+ * Count a request of any trajectory of a splitting run.
+ * @param request The index of the request among the measured requests
+ * @param weight The weight of the level that the trajectory was on
+ * @param main True for the main trajectory, whose requests are also counted unweighted
+ */
+void StatCounter::countSplit(uint64_t request, double weight, const Provisioning &p, bool main) {
+	PHASE_SCOPE(STATS);
+	Splitting::Batch &b=splitting.batches[request/splitting.batchSize];
+	if(main) {
+		++b.requests;
+		b.bw+=p.bandwidth;
+	}
+	if(p.state!=Provisioning::SUCCESS) {
+		b.blocked+=weight;
+		b.bwBlocked+=weight*p.bandwidth;
+	}
+}
+
+/**
+ * Find the end of the warm-up from the data instead of discarding a fixed
+ * number of events. Everything is counted from the start, and the counters
+ * are saved after every window of requests. Once MSER-5 finds the end of
+ * the transient, the counts up to that window are removed again, so the
+ * statistics start there. This replaces the discard count.
+ * @param window The number of requests per window
+ */
+void StatCounter::enableWarmupDetection(uint64_t window) {
+	discard=0;
+	discardedTime=simTime;
+	warmupWindow=window;
+	warming=true;
+	checkpoints.assign(1,checkpoint());
+}
+
+/**
+ * Called at the end of a run. If the end of the warm-up was not found yet,
+ * the best truncation point of the whole run is used.
+ */
+void StatCounter::endWarmup() {
+	if(warming) truncate(mserTruncation(true));
+}
+
+StatCounter::Checkpoint StatCounter::checkpoint() const {
+	Checkpoint c;
+	c.nBlocked=nBlocked;
+	c.nProvisioned=nProvisioned;
+	c.nTerminated=nTerminated;
+	c.bwBlocked=bwBlocked;
+	c.bwProvisioned=bwProvisioned;
+	c.bwTerminated=bwTerminated;
+	c.perf=perf;
+	c.simTime=simTime;
+	c.survivability=survivability;
+	c.paired=paired;
+	return c;
+}
+
+/**
+ * MSER-5 on the blocking probability and the spectrum utilization of the
+ * warm-up windows. The windows are grouped into batches of five, and for
+ * each series the truncation is the number d of leading batches that
+ * minimizes the squared error of the rest divided by (k-d)^2, where k is
+ * the number of batches. The later of the two is used.
+ * @param final If false, the truncation is only accepted if it lies in the first half of the batches.
+ * @return The truncation in windows, or noTruncation.
+ */
+size_t StatCounter::mserTruncation(bool final) const {
+	const size_t k=(checkpoints.size()-1)/mserBatch;
+	if(k<(final?2:mserMinBatches)) return final?0:noTruncation;
+	std::vector<double> bp(k), util(k);
+	for(size_t j=0; j<k; ++j) {
+		const Checkpoint &a=checkpoints[j*mserBatch], &b=checkpoints[(j+1)*mserBatch];
+		bp[j]=(double)(b.nBlocked-a.nBlocked)/(b.nBlocked+b.nProvisioned-a.nBlocked-a.nProvisioned);
+		util[j]=b.simTime>a.simTime?(b.perf.utilization-a.perf.utilization)/(b.simTime-a.simTime):0.0;
+	}
+	size_t d=0;
+	for(const std::vector<double> *x:{&bp,&util}) {
+		double sum=0, sumSq=0, best=std::numeric_limits<double>::infinity();
+		size_t bestD=0;
+		for(size_t i=k; i>0; --i) {
+			sum+=(*x)[i-1];
+			sumSq+=(*x)[i-1]*(*x)[i-1];
+			const double n=k-i+1;
+			if(n<2) continue;
+			const double mser=(sumSq-sum*sum/n)/(n*n);
+			if(mser<=best) {
+				best=mser;
+				bestD=i-1;
+			}
+		}
+		d=std::max(d,bestD);
+	}
+	if(!final && d>k/2) return noTruncation;
+	return d*mserBatch;
+}
+
+/**
+ * End the warm-up: remove everything that was counted up to the end of the
+ * given window.
+ */
+void StatCounter::truncate(size_t window) {
+	const Checkpoint &c=checkpoints[window];
+	nBlocked-=c.nBlocked;
+	nProvisioned-=c.nProvisioned;
+	nTerminated-=c.nTerminated;
+	bwBlocked-=c.bwBlocked;
+	bwProvisioned-=c.bwProvisioned;
+	bwTerminated-=c.bwTerminated;
+	perf-=c.perf;
+	if(window) discardedTime=c.simTime;
+	survivability.failures-=c.survivability.failures;
+	survivability.affected-=c.survivability.affected;
+	survivability.restored-=c.survivability.restored;
+	survivability.collided-=c.survivability.collided;
+	survivability.unprotected-=c.survivability.unprotected;
+	paired.requests-=c.paired.requests;
+	paired.onlyThis-=c.paired.onlyThis;
+	paired.onlyRef-=c.paired.onlyRef;
+	paired.bwTotal-=c.paired.bwTotal;
+	paired.bwOnlyThis-=c.paired.bwOnlyThis;
+	paired.bwOnlyRef-=c.paired.bwOnlyRef;
+	truncation=window*warmupWindow;
+	warming=false;
+	std::vector<Checkpoint>().swap(checkpoints);
+}
+
+/**
+ * Divide the measured requests into batches of the given size and use the
+ * batch means as samples for the confidence intervals.
+ */
+void StatCounter::enableBatches(uint64_t size) {
+	batchSize=size;
+	samplesEnabled=true;
+}
+
+/**
+ * Add the statistics of an independent replication of the same job.
+ * The counters and metrics are pooled, and the blocking probabilities of
+ * the replication become one sample for the confidence intervals. The first
+ * replication is copied, except for its batch samples.
+ */
+void StatCounter::addReplication(const StatCounter &r) {
+	const double bp=(double)r.nBlocked/(r.nProvisioned+r.nBlocked);
+	const double bbp=(double)r.bwBlocked/(r.bwProvisioned+r.bwBlocked);
+	if(!numReplications) {
+		*this=r;
+		batchSize=0;
+		samples=Samples();
+	} else {
+		nBlocked+=r.nBlocked;
+		nProvisioned+=r.nProvisioned;
+		nTerminated+=r.nTerminated;
+		bwBlocked+=r.bwBlocked;
+		bwProvisioned+=r.bwProvisioned;
+		bwTerminated+=r.bwTerminated;
+		perf+=r.perf;
+		pooledTime+=r.simTime-r.discardedTime+r.pooledTime;
+		truncation+=r.truncation;
+		survivability+=r.survivability;
+		paired.requests+=r.paired.requests;
+		paired.onlyThis+=r.paired.onlyThis;
+		paired.onlyRef+=r.paired.onlyRef;
+		paired.bwTotal+=r.paired.bwTotal;
+		paired.bwOnlyThis+=r.paired.bwOnlyThis;
+		paired.bwOnlyRef+=r.paired.bwOnlyRef;
+		splitting.batches.insert(splitting.batches.end(),
+				r.splitting.batches.begin(),r.splitting.batches.end());
+		splitting.retrials+=r.splitting.retrials;
+#ifdef PHASE_TIMERS
+		for(size_t i=0; i<phaseTicks.size(); ++i) phaseTicks[i]+=r.phaseTicks[i];
+#endif
+	}
+	++numReplications;
+	samplesEnabled=true;
+	samples.add(bp,bbp);
+}
+
+/**
+ * True if there are at least MIN_CI_SAMPLES samples and the confidence
+ * interval of the blocking probability is narrower than the given fraction
+ * of its mean. Never true while nothing was blocked.
+ */
+bool StatCounter::isPrecise(double relHalfWidth) const {
+	return samples.n>=MIN_CI_SAMPLES && samples.sumBP>0
+			&& samples.halfWidthBP()<=relHalfWidth*samples.meanBP();
+}
+
+/**
+ * Record the memory footprint of the run at its start and its peak.
+ * Unlike the other counters, this is not affected by the discard phase.
+ */
+void StatCounter::countMemory(const Memory &start, const Memory &peak) {
+	memoryCounted=true;
+	memoryStart=start;
+	memoryPeak=peak;
 }
 
 /**
@@ -71,6 +378,7 @@ void StatCounter::reset(const uint64_t discard) {
  * @param p The object describing the connection that shall be counted
  */
 void StatCounter::countProvisioning(const Provisioning&p) {
+	PHASE_SCOPE(STATS);
 	if(discard) {
 		--discard;
 		return;
@@ -82,6 +390,28 @@ void StatCounter::countProvisioning(const Provisioning&p) {
 		++nBlocked;
 		bwBlocked+=p.bandwidth;
 	}
+	if(warming && (nBlocked+nProvisioned)%warmupWindow==0) {
+		checkpoints.push_back(checkpoint());
+		if((checkpoints.size()-1)%mserBatch==0) {
+			const size_t t=mserTruncation(false);
+			if(t!=noTruncation) truncate(t);
+		}
+	}
+	if(batchSize && !warming) {
+		++batchRequests;
+		batchBw+=p.bandwidth;
+		if(p.state!=Provisioning::SUCCESS) {
+			++batchBlocked;
+			batchBwBlocked+=p.bandwidth;
+		}
+		if(batchRequests==batchSize) {
+			samples.add((double)batchBlocked/batchRequests,(double)batchBwBlocked/batchBw);
+			batchRequests=0;
+			batchBlocked=0;
+			batchBw=0;
+			batchBwBlocked=0;
+		}
+	}
 }
 
 /**
@@ -92,21 +422,21 @@ void StatCounter::countProvisioning(const Provisioning&p) {
  * @param p The object describing the connection that shall be counted
  */
 void StatCounter::countTermination(const Provisioning&p) {
+	PHASE_SCOPE(STATS);
 	if(!discard) {
 		++nTerminated;
 		bwTerminated+=p.bandwidth;
 	}
 }
 
-void StatCounter::countNetworkState(const NetworkGraph &g, const NetworkState& s, uint64_t timestamp) {
-	if(discard) {
-		simTime=timestamp;
-		return;
-	}
+/**
+ * Integrate performance metrics over the time since the last call.
+ * Called by countNetworkState() once the discard phase is over.
+ */
+void StatCounter::countPerfMetrics(const PerfMetrics &p, uint64_t timestamp) {
 	if(!discardedTime)
 		discardedTime=timestamp;
 	uint64_t deltaT=timestamp-simTime;
-	PerfMetrics p=s.getCurrentPerfMetrics();
 	perf+=p*deltaT;
 	/*
 	unsigned long int primary=s.getTotalPri();
@@ -155,7 +485,7 @@ std::ostream& operator<<(std::ostream &o, const StatCounter &s) {
 			+(s.numAmps/2)*140.0;
 	*/
 
-	uint64_t t=s.simTime-s.discardedTime;
+	uint64_t t=s.simTime-s.discardedTime+s.pooledTime;
 	StatCounter::PerfMetrics p=s.perf/t;
 
 	//When changing this, remember to change printTableHeader accordingly!
@@ -167,18 +497,114 @@ std::ostream& operator<<(std::ostream &o, const StatCounter &s) {
 			<< p.sharability <<TABLE_COL_SEPARATOR
 			//Fragmentation
 			<< p.priEnd   /(double)p.numLinks <<TABLE_COL_SEPARATOR
-			<< (double)NUM_SLOTS-(p.bkpBegin /(double)p.numLinks) <<TABLE_COL_SEPARATOR
+			<< (double)p.numSlots-(p.bkpBegin /(double)p.numLinks) <<TABLE_COL_SEPARATOR
 			<< p.priFrag  /(double)p.numLinks <<TABLE_COL_SEPARATOR
 			<< p.bkpFrag  /(double)p.numLinks <<TABLE_COL_SEPARATOR
 			<< p.totalFrag/(double)p.numLinks <<TABLE_COL_SEPARATOR
 			//Primary/backup spectrum collisions
 			<< p.collisions/(double)p.numLinks <<TABLE_COL_SEPARATOR
 			//Spectrum Utilization
-			<< p.utilization/(double)(p.numLinks*NUM_SLOTS) <<TABLE_COL_SEPARATOR
+			<< p.utilization/(double)(p.numLinks*p.numSlots) <<TABLE_COL_SEPARATOR
 			//Static energy
 			<< p.e_stat <<TABLE_COL_SEPARATOR
 			//Dynamic energy
 			<< p.e_dyn;
+	if(s.survivabilityEnabled) {
+		const StatCounter::Survivability &f=s.survivability;
+		o		<<TABLE_COL_SEPARATOR
+				//Restorability; all connections survive if no failure hit any
+				<< (f.affected?(double)f.restored/f.affected:1.0) <<TABLE_COL_SEPARATOR
+				<< f.worst <<TABLE_COL_SEPARATOR
+				//Backup collisions and lost protection per failure
+				<< (f.failures?(double)f.collided/f.failures:0.0) <<TABLE_COL_SEPARATOR
+				<< (f.failures?(double)f.unprotected/f.failures:0.0);
+	}
+	if(s.pairedEnabled) {
+		const StatCounter::Paired &d=s.paired;
+		//The difference per request is -1, 0 or 1, so its variance follows from the discordant counts.
+		const double n=d.requests;
+		const double dBP=((double)d.onlyThis-(double)d.onlyRef)/n;
+		const double var=(d.onlyThis+d.onlyRef)/n-dBP*dBP;
+		o		<<TABLE_COL_SEPARATOR
+				//Blocking probability difference to the reference and its 95% confidence half-width
+				<< dBP <<TABLE_COL_SEPARATOR
+				<< 1.96*sqrt(var/n) <<TABLE_COL_SEPARATOR
+				//Bandwidth blocking probability difference
+				<< ((double)d.bwOnlyThis-(double)d.bwOnlyRef)/d.bwTotal;
+	}
+	if(s.splittingEnabled) {
+		//The batches of all replications are pooled; each one is a sample.
+		uint64_t requests=0, bw=0;
+		double blocked=0, bwBlocked=0;
+		StatCounter::Samples batches;
+		for(auto const &b:s.splitting.batches) {
+			if(!b.requests) continue;
+			requests+=b.requests;
+			bw+=b.bw;
+			blocked+=b.blocked;
+			bwBlocked+=b.bwBlocked;
+			batches.add(b.blocked/b.requests,b.bwBlocked/b.bw);
+		}
+		o		<<TABLE_COL_SEPARATOR
+				//Blocking probabilities from all trajectories and the 95% confidence half-width
+				<< blocked/requests <<TABLE_COL_SEPARATOR
+				<< bwBlocked/bw <<TABLE_COL_SEPARATOR
+				<< batches.halfWidthBP() <<TABLE_COL_SEPARATOR
+				<< s.splitting.retrials;
+	}
+	if(s.warmupWindow) {
+		o		<<TABLE_COL_SEPARATOR
+				//Detected warm-up in requests, averaged over the replications
+				<< s.truncation/std::max<uint64_t>(1,s.numReplications);
+	}
+	if(s.samplesEnabled) {
+		o		<<TABLE_COL_SEPARATOR
+				//95% confidence half-widths of BP and BBP, and the number of batches or replications
+				<< s.samples.halfWidthBP() <<TABLE_COL_SEPARATOR
+				<< s.samples.halfWidthBBP() <<TABLE_COL_SEPARATOR
+				<< s.samples.n;
+	}
+#ifdef PHASE_TIMERS
+	//Million ticks per phase, summed over the replications
+	for(uint64_t t:s.phaseTicks) o<<TABLE_COL_SEPARATOR<<t*1e-6;
+#endif
+	return o;
+}
+
+/**
+ * Output the column titles that match operator<<.
+ */
+std::ostream& StatCounter::printTableHeader(std::ostream &o) const {
+	o<<tableHeader;
+	if(survivabilityEnabled)
+		o<<TABLE_COL_SEPARATOR
+			"\"Restorability\"" TABLE_COL_SEPARATOR
+			"\"Worst restorability\"" TABLE_COL_SEPARATOR
+			"\"Bkp collisions\"" TABLE_COL_SEPARATOR
+			"\"Lost protection\"";
+	if(pairedEnabled)
+		o<<TABLE_COL_SEPARATOR
+			"\"dBP\"" TABLE_COL_SEPARATOR
+			"\"dBP CI\"" TABLE_COL_SEPARATOR
+			"\"dBBP\"";
+	if(splittingEnabled)
+		o<<TABLE_COL_SEPARATOR
+			"\"Split BP\"" TABLE_COL_SEPARATOR
+			"\"Split BBP\"" TABLE_COL_SEPARATOR
+			"\"Split BP CI\"" TABLE_COL_SEPARATOR
+			"\"Retrials\"";
+	if(warmupWindow)
+		o<<TABLE_COL_SEPARATOR
+			"\"Warm-up\"";
+	if(samplesEnabled)
+		o<<TABLE_COL_SEPARATOR
+			"\"BP CI\"" TABLE_COL_SEPARATOR
+			"\"BBP CI\"" TABLE_COL_SEPARATOR
+			"\"Samples\"";
+#ifdef PHASE_TIMERS
+	for(const char *name:PhaseTimer::names)
+		o<<TABLE_COL_SEPARATOR "\""<<name<<" Mticks\"";
+#endif
 	return o;
 }
 
@@ -208,19 +634,10 @@ StatCounter::PerfMetrics::PerfMetrics():
 	utilization(),
 	e_stat(),
 	e_dyn(),
-	numLinks()
+	numLinks(),
+	numSlots()
 {}
 
-void StatCounter::PerfMetrics::addLink(specIndex_t bkpBegin, double bkpFrag,
-		specIndex_t priEnd, double priFrag, double totalFrag) {
-	this->bkpBegin+=bkpBegin;
-	this->bkpFrag+=bkpFrag;
-	this->priEnd+=priEnd;
-	this->priFrag+=priFrag;
-	this->totalFrag+=totalFrag;
-	if(bkpBegin<=priEnd) collisions+=1.0;
-}
-
 void StatCounter::PerfMetrics::reset() {
 	sharability=0.0;
 	priFrag=0.0;
@@ -247,6 +664,7 @@ StatCounter::PerfMetrics StatCounter::PerfMetrics::operator *(double b) const {
 	p.e_stat=e_stat;
 	p.e_dyn=e_dyn*b;
 	p.numLinks=numLinks;
+	p.numSlots=numSlots;
 	return p;
 }
 
@@ -263,6 +681,7 @@ StatCounter::PerfMetrics StatCounter::PerfMetrics::operator /(double b) const {
 	p.e_stat=e_stat;
 	p.e_dyn=e_dyn/b;
 	p.numLinks=numLinks;
+	p.numSlots=numSlots;
 	return p;
 }
 
@@ -278,5 +697,137 @@ StatCounter::PerfMetrics& StatCounter::PerfMetrics::operator +=(const PerfMetric
 	e_stat=b.e_stat;
 	e_dyn+=b.e_dyn;
 	numLinks=b.numLinks;
+	numSlots=b.numSlots;
+	return *this;
+}
+
+StatCounter::Samples::Samples():
+	n(),
+	sumBP(),
+	sumSqBP(),
+	sumBBP(),
+	sumSqBBP()
+{}
+
+void StatCounter::Samples::add(double bp, double bbp) {
+	++n;
+	sumBP+=bp;
+	sumSqBP+=bp*bp;
+	sumBBP+=bbp;
+	sumSqBBP+=bbp*bbp;
+}
+
+double StatCounter::Samples::halfWidth(double sum, double sumSq) const {
+	if(n<2) return std::numeric_limits<double>::quiet_NaN();
+	const double var=std::max(0.0,(sumSq-sum*sum/n)/(n-1));
+	const boost::math::students_t t(n-1);
+	return boost::math::quantile(boost::math::complement(t,0.025))*sqrt(var/n);
+}
+
+StatCounter::PerfMetrics& StatCounter::PerfMetrics::operator -=(const PerfMetrics& b) {
+	sharability-=b.sharability;
+	priFrag-=b.priFrag;
+	bkpFrag-=b.bkpFrag;
+	totalFrag-=b.totalFrag;
+	priEnd-=b.priEnd;
+	bkpBegin-=b.bkpBegin;
+	collisions-=b.collisions;
+	utilization-=b.utilization;
+	e_dyn-=b.e_dyn;
+	return *this;
+}
+
+StatCounter::Paired::Paired():
+	requests(),
+	onlyThis(),
+	onlyRef(),
+	bwTotal(),
+	bwOnlyThis(),
+	bwOnlyRef()
+{}
+
+StatCounter::Splitting::Splitting():
+	batchSize(1),
+	batches(),
+	retrials()
+{}
+
+StatCounter::Splitting::Batch::Batch():
+	requests(),
+	bw(),
+	blocked(),
+	bwBlocked()
+{}
+
+StatCounter::Survivability::Survivability():
+	failures(),
+	affected(),
+	restored(),
+	collided(),
+	unprotected(),
+	worst(1.0)
+{}
+
+StatCounter::Survivability& StatCounter::Survivability::operator +=(const Survivability& b) {
+	failures+=b.failures;
+	affected+=b.affected;
+	restored+=b.restored;
+	collided+=b.collided;
+	unprotected+=b.unprotected;
+	worst=std::min(worst,b.worst);
 	return *this;
 }
+
+StatCounter::Memory::Memory():
+	linkState(),
+	sharing(),
+	nodeFree(),
+	stateOther(),
+	dijkstra(),
+	connections(),
+	failures()
+{}
+
+uint64_t StatCounter::Memory::total() const {
+	return linkState+sharing+nodeFree+stateOther+dijkstra+connections+failures;
+}
+
+StatCounter::Memory& StatCounter::Memory::operator +=(const Memory& b) {
+	linkState+=b.linkState;
+	sharing+=b.sharing;
+	nodeFree+=b.nodeFree;
+	stateOther+=b.stateOther;
+	dijkstra+=b.dijkstra;
+	connections+=b.connections;
+	failures+=b.failures;
+	return *this;
+}
+
+/**
+ * The bytes of one active connection: its pool slot and queue entry in the
+ * ConnectionQueue and the edges of both paths.
+ */
+uint64_t StatCounter::Memory::connectionBytes(size_t priHops, size_t bkpHops) {
+	return sizeof(Provisioning)+sizeof(ConnectionQueue::Entry)
+			+(priHops+bkpHops)*sizeof(NetworkGraph::Graph::edge_descriptor);
+}
+
+/// A number of bytes with a binary unit that keeps it readable.
+static std::string formatBytes(uint64_t bytes) {
+	static const char *const units[]={"B","KiB","MiB","GiB","TiB"};
+	double v=bytes;
+	size_t u=0;
+	while(v>=1024 && u<4) {
+		v/=1024;
+		++u;
+	}
+	return (boost::format(u?"%.1f %s":"%.0f %s") %v %units[u]).str();
+}
+
+std::ostream& operator<<(std::ostream &o, const StatCounter::Memory &m) {
+	o<<formatBytes(m.total())<<" (link state "<<formatBytes(m.linkState)
+		<<", sharing "<<formatBytes(m.sharing)<<", node free "<<formatBytes(m.nodeFree)
+		<<", other state "<<formatBytes(m.stateOther)<<", dijkstra "<<formatBytes(m.dijkstra)
+		<<", connections "<<formatBytes(m.connections)<<", failures "<<formatBytes(m.failures)<<')';
+	return o;
+}
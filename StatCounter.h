@@ -25,26 +25,140 @@
 
 #include <cstdint>
 #include <iostream>
+#include <vector>
 
 #include "globaldef.h"
 #include "NetworkGraph.h"
+#include "PhaseTimer.h"
 #include "SimulationMsgs.h"
 
-class NetworkState;
-
 /**
  * \brief Keeps track of blocking statistics and performance metrics during a simulation run.
  */
 class StatCounter {
 public:
-	StatCounter(const uint64_t discard);
+	StatCounter(const uint64_t discard, const uint64_t startTime=0);
 	virtual ~StatCounter();
 	void reset(const uint64_t discard);
 	void countProvisioning(const Provisioning&p);
 	void countTermination(const Provisioning&p);
-	void countNetworkState(const NetworkGraph &g, const NetworkState &s, uint64_t timestamp);
+	/// True while events are still being discarded and the network state is not looked at.
+	bool isDiscarding() const {return discard;}
+	template<class State>
+	void countNetworkState(const NetworkGraph &g, const State &s, uint64_t timestamp);
 	friend std::ostream& operator<<(std::ostream &o, const StatCounter &s);
-	static const char* const tableHeader;
+	std::ostream &printTableHeader(std::ostream &o) const;
+	/**
+	 * \brief Restorability of the active connections under all single link failures.
+	 * See FailureAnalysis.
+	 */
+	struct Survivability {
+		uint64_t failures; ///< Number of failure scenarios.
+		uint64_t affected; ///< Connections whose primary was hit, summed over all failures.
+		uint64_t restored; ///< Hit connections that could switch to their backup.
+		uint64_t collided; ///< Hit connections whose backup spectrum collided with another one.
+		uint64_t unprotected; ///< Connections that lost their backup reservation.
+		double worst; ///< The lowest fraction of restored connections of a single failure.
+		Survivability();
+		Survivability &operator +=(const Survivability &b);
+	};
+	void enableSurvivability();
+	void countSurvivability(const Survivability &s);
+	/**
+	 * \brief Blocking compared request by request with a reference run on the same requests.
+	 * See Simulation::runLockstep().
+	 */
+	struct Paired {
+		uint64_t requests; ///< Number of compared requests.
+		uint64_t onlyThis; ///< Requests that were blocked here but not in the reference run.
+		uint64_t onlyRef; ///< Requests that were blocked in the reference run but not here.
+		uint64_t bwTotal; ///< Total requested bandwidth.
+		uint64_t bwOnlyThis, bwOnlyRef; ///< Bandwidth of onlyThis and onlyRef.
+		Paired();
+	};
+	void enablePaired();
+	void countPaired(bool blocked, bool refBlocked, bandwidth_t bw);
+	/**
+	 * \brief Independent observations of the blocking probabilities.
+	 *
+	 * An observation is either a batch of requests within one run (batch
+	 * means) or a whole replication. Their spread gives the confidence
+	 * intervals of BP and BBP.
+	 */
+	struct Samples {
+		uint64_t n;
+		double sumBP, sumSqBP, sumBBP, sumSqBBP;
+		Samples();
+		void add(double bp, double bbp);
+		double meanBP() const {return sumBP/n;}
+		/// Half-width of the 95% confidence interval of the mean, from Student's t distribution.
+		double halfWidthBP() const {return halfWidth(sumBP,sumSqBP);}
+		double halfWidthBBP() const {return halfWidth(sumBBP,sumSqBBP);}
+	private:
+		double halfWidth(double sum, double sumSq) const;
+	};
+	/**
+	 * \brief Blocking counted over all trajectories of a splitting run.
+	 * See Simulation::simulateSplitting().
+	 *
+	 * Each blocked request is weighted with the inverse number of
+	 * trajectories that were expected to reach its level, so the sums
+	 * estimate the blocking of the main trajectory. They are kept per batch
+	 * of requests of the main trajectory; the batches are the samples for
+	 * the confidence interval.
+	 */
+	struct Splitting {
+		/**
+		 * \brief The counters of one batch.
+		 */
+		struct Batch {
+			uint64_t requests; ///< Requests of the main trajectory.
+			uint64_t bw; ///< Requested bandwidth of the main trajectory.
+			double blocked, bwBlocked; ///< Weighted over all trajectories.
+			Batch();
+		};
+		uint64_t batchSize;
+		std::vector<Batch> batches;
+		uint64_t retrials; ///< Number of trajectories besides the main one.
+		Splitting();
+	};
+	void enableSplitting(uint64_t numRequests, uint64_t batchSize);
+	void countSplit(uint64_t request, double weight, const Provisioning &p, bool main);
+	void countRetrial() {++splitting.retrials;}
+	void enableWarmupDetection(uint64_t window);
+	void endWarmup();
+	void enableBatches(uint64_t size);
+	void addReplication(const StatCounter &r);
+	bool isPrecise(double relHalfWidth) const;
+	const Samples &getSamples() const {return samples;}
+#ifdef PHASE_TIMERS
+	/// The ticks of each phase of the run, see PhaseTimer.
+	PhaseTimer::Ticks &getPhaseTicks() {return phaseTicks;}
+#endif
+	/**
+	 * \brief Bytes held by the data structures of one Simulation.
+	 *
+	 * Copy-on-write pages are counted in full even while they are shared
+	 * with a Snapshot, so this is an upper bound for the memory of a run.
+	 */
+	struct Memory {
+		uint64_t linkState; ///< NetworkState link pages.
+		uint64_t sharing; ///< NetworkState sharing matrix.
+		uint64_t nodeFree; ///< NetworkState per-node prefix sums.
+		uint64_t stateOther; ///< The rest of the NetworkState, including the undo logs.
+		uint64_t dijkstra; ///< NetworkGraph::DijkstraData buffers.
+		uint64_t connections; ///< The active connections with their paths.
+		uint64_t failures; ///< FailureAnalysis indexes.
+		Memory();
+		uint64_t total() const;
+		Memory &operator +=(const Memory &b);
+		static uint64_t connectionBytes(size_t priHops, size_t bkpHops);
+		friend std::ostream& operator<<(std::ostream &o, const Memory &m);
+	};
+	void countMemory(const Memory &start, const Memory &peak);
+	bool hasMemory() const {return memoryCounted;}
+	const Memory &getMemoryStart() const {return memoryStart;}
+	const Memory &getMemoryPeak() const {return memoryPeak;}
 	struct PerfMetrics{
 		double sharability;
 		double priFrag, bkpFrag, totalFrag;
@@ -54,13 +168,13 @@ public:
 		double e_stat;
 		double e_dyn;
 		linkIndex_t numLinks;
+		specIndex_t numSlots;
 		PerfMetrics();
-		void addLink(specIndex_t bkpBegin, double bkpFrag, specIndex_t priEnd,
-				double priFrag, double totalFrag);
 		void reset();
 		PerfMetrics operator *(double b) const;
 		PerfMetrics operator /(double b) const;
 		PerfMetrics &operator +=(const PerfMetrics &b);
+		PerfMetrics &operator -=(const PerfMetrics &b);
 	};
 private:
 	/**
@@ -84,6 +198,67 @@ private:
 
 	PerfMetrics perf;
 	uint64_t simTime, discardedTime;
+	bool survivabilityEnabled;
+	Survivability survivability;
+	bool pairedEnabled;
+	Paired paired;
+	bool splittingEnabled;
+	Splitting splitting;
+	/// Requests per batch for batch means, or 0.
+	uint64_t batchSize;
+	/// The counters of the current batch.
+	uint64_t batchRequests, batchBlocked, batchBw, batchBwBlocked;
+	bool samplesEnabled;
+	Samples samples;
+	uint64_t numReplications;
+	/// The measured time of all replications but the first.
+	uint64_t pooledTime;
+	/**
+	 * \brief The counters at the end of a warm-up window.
+	 */
+	struct Checkpoint {
+		uint64_t nBlocked, nProvisioned, nTerminated;
+		uint64_t bwBlocked, bwProvisioned, bwTerminated;
+		PerfMetrics perf;
+		uint64_t simTime;
+		Survivability survivability;
+		Paired paired;
+	};
+	/// Requests per warm-up window, or 0 if the warm-up is not detected.
+	uint64_t warmupWindow;
+	/// True until the end of the warm-up was found; everything is counted meanwhile.
+	bool warming;
+	/// One checkpoint at the start and one after each window, while warming.
+	std::vector<Checkpoint> checkpoints;
+	/// The number of requests that were cut off as warm-up.
+	uint64_t truncation;
+	Checkpoint checkpoint() const;
+	size_t mserTruncation(bool final) const;
+	void truncate(size_t window);
+	bool memoryCounted;
+	Memory memoryStart, memoryPeak;
+#ifdef PHASE_TIMERS
+	PhaseTimer::Ticks phaseTicks;
+#endif
+	static const char* const tableHeader;
+	void countPerfMetrics(const PerfMetrics &p, uint64_t timestamp);
 };
 
+/**
+ * Count the performance metrics of a network state.
+ * This is called whenever the simulation time advances, before the network
+ * state changes. The metrics are weighted with the time since the last call.
+ *
+ * @param s A NetworkState for any number of slots
+ */
+template<class State>
+void StatCounter::countNetworkState(const NetworkGraph &g, const State &s, uint64_t timestamp) {
+	PHASE_SCOPE(STATS);
+	if(discard) {
+		simTime=timestamp;
+		return;
+	}
+	countPerfMetrics(s.getCurrentPerfMetrics(),timestamp);
+}
+
 #endif /* STATCOUNTER_H_ */
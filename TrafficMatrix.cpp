@@ -0,0 +1,115 @@
+/**
+ * @file TrafficMatrix.cpp
+ *
+ */
+
+/*
+ * This file is part of eonsim.
+ *
+ * eonsim is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * eonsim is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with eonsim.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#include "TrafficMatrix.h"
+
+#include <cmath>
+#include <limits>
+#include <sstream>
+#include <stdexcept>
+#include <string>
+
+AliasTable::AliasTable():
+	prob(),
+	alias()
+{}
+
+/**
+ * Vose's construction: the weights are scaled to an average of 1, then each
+ * index with a scaled weight below 1 is filled up from one above 1, which
+ * becomes its alias.
+ */
+AliasTable::AliasTable(const std::vector<double> &weights):
+	prob(weights.size()),
+	alias(weights.size())
+{
+	double total=0;
+	for(double w:weights) {
+		if(!(w>=0) || std::isinf(w)) throw std::runtime_error("Weights must be finite and not negative");
+		total+=w;
+	}
+	if(!(total>0)) throw std::runtime_error("At least one weight must be positive");
+	std::vector<uint32_t> small, large;
+	for(size_t i=0; i<weights.size(); ++i) {
+		prob[i]=weights[i]*weights.size()/total;
+		alias[i]=i;
+		(prob[i]<1?small:large).push_back(i);
+	}
+	while(!small.empty() && !large.empty()) {
+		const uint32_t s=small.back(), l=large.back();
+		small.pop_back();
+		alias[s]=l;
+		prob[l]-=1-prob[s];
+		if(prob[l]<1) {
+			large.pop_back();
+			small.push_back(l);
+		}
+	}
+	//what is left only differs from 1 by rounding errors
+	for(uint32_t i:small) prob[i]=1;
+	for(uint32_t i:large) prob[i]=1;
+}
+
+TrafficMatrix::TrafficMatrix(std::istream &s):
+	numNodes(0),
+	pairs(),
+	pairBandwidth(),
+	bandwidths()
+{
+	size_t n;
+	if(!(s>>n) || n<2 || n>std::numeric_limits<nodeIndex_t>::max())
+		throw std::runtime_error("The traffic matrix must start with the number of nodes");
+	numNodes=n;
+	std::vector<double> weights(n*n);
+	for(size_t i=0; i<n*n; ++i)
+		if(!(s>>weights[i])) throw std::runtime_error("The traffic matrix is incomplete");
+	for(size_t i=0; i<n; ++i) weights[i*n+i]=0;
+	pairs=AliasTable(weights);
+
+	pairBandwidth.assign(n*n,-1);
+	std::string line;
+	for(unsigned int lineNo=0; std::getline(s,line); ++lineNo) {
+		std::istringstream ls(line);
+		size_t src, dst;
+		if(!(ls>>src) && ls.eof()) continue; //empty line or the end of the matrix
+		if(!ls || !(ls>>dst) || src>=n || dst>=n || src==dst)
+			throw std::runtime_error("Invalid node pair in line "+std::to_string(lineNo)
+					+" after the traffic matrix");
+		BandwidthDistribution d;
+		std::vector<double> w;
+		long bw;
+		double bwWeight;
+		while(ls>>bw>>bwWeight) {
+			if(bw<=0 || bw>std::numeric_limits<bandwidth_t>::max())
+				throw std::runtime_error("Invalid bandwidth in line "+std::to_string(lineNo)
+						+" after the traffic matrix");
+			d.values.push_back(bw);
+			w.push_back(bwWeight);
+		}
+		if(!ls.eof() || d.values.empty())
+			throw std::runtime_error("Invalid bandwidth distribution in line "+std::to_string(lineNo)
+					+" after the traffic matrix");
+		d.table=AliasTable(w);
+		pairBandwidth[src*n+dst]=bandwidths.size();
+		bandwidths.push_back(d);
+	}
+}
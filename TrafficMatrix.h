@@ -0,0 +1,109 @@
+/**
+ * @file TrafficMatrix.h
+ *
+ */
+
+/*
+ * This file is part of eonsim.
+ *
+ * eonsim is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * eonsim is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with eonsim.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#ifndef TRAFFICMATRIX_H_
+#define TRAFFICMATRIX_H_
+
+#include <boost/random/uniform_01.hpp>
+#include <boost/random/uniform_int_distribution.hpp>
+#include <stddef.h>
+#include <cstdint>
+#include <istream>
+#include <vector>
+
+#include "globaldef.h"
+
+/**
+ * \brief Draws an index with probability proportional to its weight in O(1).
+ *
+ * This is Walker's alias method with Vose's construction: each index i
+ * keeps the probability prob[i] of being taken when it is drawn uniformly,
+ * and the index alias[i] that is taken otherwise. A sample costs one
+ * uniform index and one uniform real, whatever the number of weights.
+ */
+class AliasTable {
+public:
+	AliasTable();
+	/// The weights must not be negative and must not all be zero.
+	explicit AliasTable(const std::vector<double> &weights);
+	template<class Engine> size_t operator()(Engine &rng) const {
+		const size_t i=boost::random::uniform_int_distribution<size_t>(0,prob.size()-1)(rng);
+		return boost::random::uniform_01<double>()(rng)<prob[i]?i:alias[i];
+	}
+	size_t size() const {return prob.size();}
+private:
+	std::vector<double> prob;
+	std::vector<uint32_t> alias;
+};
+
+/**
+ * \brief The demand between each pair of nodes.
+ *
+ * The file starts with the number of nodes n, followed by an n x n matrix
+ * of non-negative weights. The weight in row i and column j is proportional
+ * to the probability that a request goes from node i to node j; the
+ * diagonal is ignored. Each of the following lines is optional and gives
+ * the bandwidth distribution of one pair: the source, the destination and
+ * then pairs of a bandwidth in Gbit/s and its weight. Requests between the
+ * other pairs take their bandwidth from the uniform "bwmin" to "bwmax"
+ * distribution of the job.
+ *
+ * A TrafficMatrix is never modified after loading, so it is shared by all
+ * threads.
+ */
+class TrafficMatrix {
+public:
+	/// Throws std::runtime_error if the matrix can not be read.
+	explicit TrafficMatrix(std::istream &s);
+	nodeIndex_t getNumNodes() const {return numNodes;}
+	/**
+	 * Draw the source and destination of a request. The bandwidth is set
+	 * if the pair has its own distribution, and is left alone otherwise.
+	 * @return true if the bandwidth was set.
+	 */
+	template<class Engine> bool operator()(Engine &rng, nodeIndex_t &source, nodeIndex_t &dest,
+			unsigned int &bandwidth) const {
+		const size_t p=pairs(rng);
+		source=p/numNodes;
+		dest=p%numNodes;
+		const int32_t b=pairBandwidth[p];
+		if(b<0) return false;
+		bandwidth=bandwidths[b].values[bandwidths[b].table(rng)];
+		return true;
+	}
+private:
+	/**
+	 * \brief The bandwidths of one pair and the table to choose among them.
+	 */
+	struct BandwidthDistribution {
+		std::vector<unsigned int> values;
+		AliasTable table;
+	};
+	nodeIndex_t numNodes;
+	/// Over the pairs (i,j) at index i*numNodes+j.
+	AliasTable pairs;
+	/// The index into bandwidths of each pair, or -1 for the job's distribution.
+	std::vector<int32_t> pairBandwidth;
+	std::vector<BandwidthDistribution> bandwidths;
+};
+
+#endif /* TRAFFICMATRIX_H_ */
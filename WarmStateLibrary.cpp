@@ -0,0 +1,230 @@
+/**
+ * @file WarmStateLibrary.cpp
+ *
+ */
+
+/*
+ * This file is part of eonsim.
+ *
+ * eonsim is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * eonsim is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with eonsim.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#include "WarmStateLibrary.h"
+
+#include <boost/graph/compressed_sparse_row_graph.hpp>
+#include <sys/stat.h>
+#include <unistd.h>
+#include <algorithm>
+#include <cerrno>
+#include <cstdio>
+#include <cstring>
+#include <fstream>
+#include <functional>
+#include <iomanip>
+#include <iostream>
+#include <iterator>
+#include <sstream>
+#include <stdexcept>
+#include <thread>
+
+namespace {
+const char magic[8]={'E','O','N','W','A','R','M','1'};
+
+/// Parameters that only control a run and do not change its steady state.
+const char *const runParams[]={"iters","discard","rediscard","reps","relci","batchsize",
+		"mser","parallel","check","checkbudget","failsample","memreport","memo",
+		"restart","rfrom","rsplit"};
+
+uint64_t fnv1a(const std::string &s) {
+	uint64_t h=0xcbf29ce484222325ULL;
+	for(unsigned char c:s) {
+		h^=c;
+		h*=0x100000001b3ULL;
+	}
+	return h;
+}
+
+std::string hex(uint64_t v) {
+	std::ostringstream s;
+	s<<std::hex<<std::setw(16)<<std::setfill('0')<<v;
+	return s.str();
+}
+
+void put(std::string &out, uint64_t v, size_t bytes) {
+	for(size_t i=0; i<bytes; ++i, v>>=8) out.push_back((char)(v&0xff));
+}
+
+/**
+ * \brief Reads little endian values from a buffer and throws at its end.
+ */
+class Reader {
+public:
+	explicit Reader(const std::string &data): data(data), pos(0) {}
+	uint64_t get(size_t bytes) {
+		if(data.size()-pos<bytes) throw std::runtime_error("truncated");
+		uint64_t v=0;
+		for(size_t i=bytes; i>0; --i) v=(v<<8)|(unsigned char)data[pos+i-1];
+		pos+=bytes;
+		return v;
+	}
+	std::string getString(size_t length) {
+		if(data.size()-pos<length) throw std::runtime_error("truncated");
+		pos+=length;
+		return data.substr(pos-length,length);
+	}
+	bool atEnd() const {return pos==data.size();}
+private:
+	const std::string &data;
+	size_t pos;
+};
+
+void putPath(std::string &out, const NetworkGraph::Path &p) {
+	put(out,p.size(),2);
+	for(auto const &e:p) put(out,e.idx,2);
+}
+
+void getPath(Reader &in, const NetworkGraph &topology, NetworkGraph::Path &p) {
+	const size_t n=in.get(2);
+	p.clear();
+	for(size_t i=0; i<n; ++i) {
+		const NetworkGraph::Graph::edges_size_type idx=in.get(2);
+		if(idx>=num_edges(topology.g)) throw std::runtime_error("invalid link");
+		p.push_back(edge_from_index(idx,topology.g));
+	}
+}
+}
+
+WarmStateLibrary::WarmStateLibrary(const std::string &dir, const NetworkGraph &topology,
+		const std::string &trafficMatrix):
+	dir(dir),
+	context()
+{
+	if(mkdir(dir.c_str(),0777)!=0 && errno!=EEXIST)
+		throw std::runtime_error("Can not create the warm state library "+dir+": "+strerror(errno));
+	struct stat st;
+	if(stat(dir.c_str(),&st)!=0 || !S_ISDIR(st.st_mode))
+		throw std::runtime_error(dir+" is not a directory");
+	std::ostringstream links;
+	auto es=edges(topology.g);
+	for(auto e=es.first; e!=es.second; ++e)
+		links<<source(*e,topology.g)<<'-'<<target(*e,topology.g)<<':'<<topology.link_lengths[e->idx]<<',';
+	context="topology="+hex(fnv1a(links.str()))+";traffic="
+			+(trafficMatrix.empty()?std::string("uniform"):hex(fnv1a(trafficMatrix)));
+}
+
+std::string WarmStateLibrary::key(const JobIterator::job_t &job) const {
+	std::ostringstream k;
+	k<<std::setprecision(17)<<context<<";alg="<<job.algname;
+	for(auto const &p:job.params) {
+		if(std::find_if(std::begin(runParams),std::end(runParams),
+				[&p](const char *n){return p.first==n;})!=std::end(runParams))
+			continue;
+		k<<';'<<p.first<<'='<<p.second;
+	}
+	if(job.replication) k<<";replication="<<job.replication;
+	return k.str();
+}
+
+std::string WarmStateLibrary::fileName(const std::string &key) const {
+	return dir+"/"+hex(fnv1a(key))+".warm";
+}
+
+bool WarmStateLibrary::contains(const JobIterator::job_t &job) const {
+	return access(fileName(key(job)).c_str(),F_OK)==0;
+}
+
+bool WarmStateLibrary::load(const JobIterator::job_t &job, const NetworkGraph &topology,
+		WarmState &w) const {
+	const std::string k=key(job), name=fileName(k);
+	std::ifstream f(name,std::ifstream::binary);
+	if(!f) return false;
+	const std::string data((std::istreambuf_iterator<char>(f)),std::istreambuf_iterator<char>());
+	try {
+		Reader in(data);
+		if(in.getString(sizeof(magic))!=std::string(magic,sizeof(magic)))
+			throw std::runtime_error("not a warm state");
+		//a different key with the same hash
+		if(in.getString(in.get(4))!=k) return false;
+		w.numSlots=in.get(2);
+		w.numFibers=in.get(2);
+		w.currentTime=in.get(8);
+		w.nextRequestTime=in.get(8);
+		const uint64_t n=in.get(8);
+		w.connections.clear();
+		for(uint64_t i=0; i<n; ++i) {
+			std::pair<simtime_t, Provisioning> c;
+			Provisioning &p=c.second;
+			c.first=in.get(8);
+			p.bandwidth=in.get(2);
+			p.priFiber=in.get(2);
+			p.bkpFiber=in.get(2);
+			p.priSpecBegin=in.get(2);
+			p.priSpecEnd=in.get(2);
+			p.priMod=(modulation_t)in.get(1);
+			p.bkpSpecBegin=in.get(2);
+			p.bkpSpecEnd=in.get(2);
+			p.bkpMod=(modulation_t)in.get(1);
+			getPath(in,topology,p.priPath);
+			getPath(in,topology,p.bkpPath);
+			p.state=Provisioning::SUCCESS;
+			if(p.priFiber>=w.numFibers || p.bkpFiber>=w.numFibers
+					|| p.priSpecEnd>w.numSlots || p.bkpSpecEnd>w.numSlots
+					|| p.priMod>MOD_NONE || p.bkpMod>MOD_NONE)
+				throw std::runtime_error("invalid connection");
+			w.connections.push_back(std::move(c));
+		}
+		if(!in.atEnd()) throw std::runtime_error("trailing data");
+	} catch(std::runtime_error &e) {
+		std::cerr<<"Ignoring the warm state "<<name<<": "<<e.what()<<std::endl;
+		return false;
+	}
+	return true;
+}
+
+void WarmStateLibrary::store(const JobIterator::job_t &job, const WarmState &w) const {
+	const std::string k=key(job);
+	std::string data(magic,sizeof(magic));
+	put(data,k.size(),4);
+	data+=k;
+	put(data,w.numSlots,2);
+	put(data,w.numFibers,2);
+	put(data,w.currentTime,8);
+	put(data,w.nextRequestTime,8);
+	put(data,w.connections.size(),8);
+	for(auto const &c:w.connections) {
+		const Provisioning &p=c.second;
+		put(data,c.first,8);
+		put(data,p.bandwidth,2);
+		put(data,p.priFiber,2);
+		put(data,p.bkpFiber,2);
+		put(data,p.priSpecBegin,2);
+		put(data,p.priSpecEnd,2);
+		put(data,p.priMod,1);
+		put(data,p.bkpSpecBegin,2);
+		put(data,p.bkpSpecEnd,2);
+		put(data,p.bkpMod,1);
+		putPath(data,p.priPath);
+		putPath(data,p.bkpPath);
+	}
+	const std::string name=fileName(k);
+	std::ostringstream tmp;
+	tmp<<name<<".tmp"<<getpid()<<'-'<<std::hash<std::thread::id>()(std::this_thread::get_id());
+	std::ofstream out(tmp.str(),std::ofstream::binary|std::ofstream::trunc);
+	out.write(data.data(),data.size());
+	out.close();
+	if(!out || rename(tmp.str().c_str(),name.c_str())!=0) {
+		std::cerr<<"Can not store the warm state "<<name<<std::endl;
+		std::remove(tmp.str().c_str());
+	}
+}
@@ -0,0 +1,87 @@
+/**
+ * @file WarmStateLibrary.h
+ *
+ */
+
+/*
+ * This file is part of eonsim.
+ *
+ * eonsim is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * eonsim is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with eonsim.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#ifndef WARMSTATELIBRARY_H_
+#define WARMSTATELIBRARY_H_
+
+#include <cstdint>
+#include <string>
+#include <utility>
+#include <vector>
+
+#include "globaldef.h"
+#include "JobIterator.h"
+#include "NetworkGraph.h"
+#include "SimulationMsgs.h"
+
+/**
+ * \brief The active connections of a simulation in steady state.
+ *
+ * The NetworkState follows from the connections, so it is not stored.
+ */
+struct WarmState {
+	simtime_t currentTime, nextRequestTime;
+	fiberIndex_t numFibers;
+	specIndex_t numSlots;
+	/// The connections with their expiry times, in the order in which they expire.
+	std::vector<std::pair<simtime_t, Provisioning> > connections;
+};
+
+/**
+ * \brief A directory of WarmState files, one per job.
+ *
+ * A job's state is found by a key of the topology, the traffic matrix, the
+ * algorithm and all parameters that influence the steady state, i.e. all
+ * except those that only control the run (see runParams in the .cpp file).
+ * Each replication of a job (see "reps") has its own state, so that the
+ * replications stay independent; replication 0 shares the key of the
+ * unreplicated job. Each file is named after a 64 bit hash of its key and contains the key
+ * itself, so collisions are detected.
+ *
+ * Files are written to a temporary name and renamed, so several workers or
+ * programs can share a library; the first state that is stored for a key
+ * is kept.
+ */
+class WarmStateLibrary {
+public:
+	/**
+	 * Creates the directory if needed. Throws std::runtime_error if that fails.
+	 * @param trafficMatrix The contents of the traffic matrix file, or empty
+	 */
+	WarmStateLibrary(const std::string &dir, const NetworkGraph &topology,
+			const std::string &trafficMatrix);
+	bool contains(const JobIterator::job_t &job) const;
+	/**
+	 * Read the state of a job.
+	 * @return false if there is none, or if it is unreadable (with a warning).
+	 */
+	bool load(const JobIterator::job_t &job, const NetworkGraph &topology, WarmState &w) const;
+	void store(const JobIterator::job_t &job, const WarmState &w) const;
+private:
+	std::string dir;
+	/// The part of the keys that is the same for all jobs.
+	std::string context;
+	std::string key(const JobIterator::job_t &job) const;
+	std::string fileName(const std::string &key) const;
+};
+
+#endif /* WARMSTATELIBRARY_H_ */
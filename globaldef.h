@@ -30,7 +30,7 @@
 
 #define SLOT_WIDTH 12.5
 #define DISTANCE_UNIT 5.0
-#define NUM_SLOTS 320
+#define DEFAULT_NUM_SLOTS 320
 #define AMP_DIST 80.0
 
 #define DEFAULT_SIM_ITERS  100000
@@ -38,6 +38,14 @@
 
 #define AVG_INTARRIVAL 1000
 
+#define MIN_CI_SAMPLES 5
+
+#define SPECULATION_DEPTH 4
+
+#define FRAG_SCALE (1LL<<32)
+
+#define SPLIT_BATCHES 20
+
 #define DEFAULT_K 4
 
 #define DEFAULT_LOAD_MIN 150
@@ -51,10 +59,22 @@
 
 #define TABLE_COL_SEPARATOR ";"
 
+#define HUGEPAGE_SIZE (2UL<<20)
+#define HUGEPAGE_MIN_BLOCK (256UL<<10)
+
+/**
+ * Calls F(n) for each number of spectrum slots per link that the program
+ * supports. NetworkState, the heuristics and the simulation are compiled
+ * for each of these values, so that all spectrum loops have constant bounds.
+ * The value to use is selected at run time with the "slots" parameter.
+ */
+#define FOR_EACH_NUM_SLOTS(F) F(320) F(640) F(960)
+
 typedef unsigned short specIndex_t;
 typedef unsigned short bandwidth_t;
 typedef unsigned short nodeIndex_t;
 typedef unsigned short linkIndex_t;
+typedef unsigned short fiberIndex_t;
 typedef unsigned long simtime_t;
 typedef unsigned short distance_t;
 
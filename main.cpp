@@ -23,57 +23,294 @@
 #include <boost/program_options.hpp>
 #include <stddef.h>
 #include <algorithm>
+#include <cmath>
 #include <condition_variable>
+#include <deque>
+#include <fstream>
 #include <functional>
 #include <iomanip>
 #include <iostream>
 #include <iterator>
+#include <limits>
 #include <map>
+#include <set>
+#include <memory>
 #include <mutex>
+#include <sstream>
+#include <stdexcept>
 #include <string>
 #include <thread>
 #include <utility>
 #include <vector>
 
 #include "globaldef.h"
+#include "HugePages.h"
 #include "JobIterator.h"
 #include "NetworkGraph.h"
 #include "provisioning_schemes/ProvisioningSchemeFactory.h"
+#include "RequestTrace.h"
 #include "Simulation.h"
 #include "StatCounter.h"
+#include "TrafficMatrix.h"
+#include "WarmStateLibrary.h"
 
 namespace po = boost::program_options;
 
 std::mutex mtx;
 std::condition_variable cvWorker, cvMain;
-JobIterator::job_t nextWork;
-std::map<size_t,std::pair<JobIterator::job_t,const StatCounter>> results;
+/// A group of jobs that are run together. Empty to stop the worker.
+std::vector<JobIterator::job_t> nextWork;
+/// The groups that the workers have finished, with the statistics of each job.
+std::vector<std::pair<std::vector<JobIterator::job_t>,std::vector<StatCounter> > > finished;
 bool newWork, newResult;
 
-static void worker(const NetworkGraph &g) {
-	Simulation sim(g);
+/// How the jobs are grouped and how a worker runs a group of several jobs.
+enum GroupMode {SEPARATE, LOCKSTEP, CHAIN, FORK};
+
+/**
+ * \brief The replications of a group of jobs, see the "reps" parameter.
+ *
+ * The replications are run by any idle worker. They are merged in the order
+ * of their replication number once the group is complete, so the result
+ * does not depend on which replication finished first. With "relci", the
+ * precision is checked for each prefix 0..n-1 of the replications as soon as
+ * it is complete, and the result pools the first precise prefix; replications
+ * after it that were already running are dropped.
+ */
+struct Replications {
+	unsigned int total, dispatched;
+	/// Stop when the relative confidence half-width of every job's BP reaches this, or 0.
+	double relci;
+	bool stopped;
+	/// The length of the longest complete prefix of replications that was checked.
+	unsigned int checked;
+	/// The statistics of each finished replication, by replication number.
+	std::map<unsigned int,std::vector<StatCounter> > runs;
+	std::vector<StatCounter> merge(unsigned int n) const;
+	void check(std::deque<std::vector<JobIterator::job_t> > &pending, size_t first);
+	bool complete() const;
+};
+
+/**
+ * Merge the replications 0..n-1, which must all have finished.
+ */
+std::vector<StatCounter> Replications::merge(unsigned int n) const {
+	std::vector<StatCounter> merged(runs.begin()->second.size(),StatCounter(0));
+	for(auto r=runs.begin(); r!=runs.end() && r->first<n; ++r)
+		for(size_t i=0; i<merged.size(); ++i) merged[i].addReplication(r->second[i]);
+	return merged;
+}
+
+/**
+ * Check the newly completed prefixes of the replications for precision.
+ * Once one is precise, the replications of the group that have not started
+ * yet are removed from pending.
+ */
+void Replications::check(std::deque<std::vector<JobIterator::job_t> > &pending, size_t first) {
+	while(!stopped && runs.count(checked)) {
+		++checked;
+		if(relci<=0) continue;
+		const std::vector<StatCounter> merged=merge(checked);
+		if(std::all_of(merged.begin(),merged.end(),
+				[this](const StatCounter &c){return c.isPrecise(relci);})) {
+			stopped=true;
+			pending.erase(std::remove_if(pending.begin(),pending.end(),
+					[first](const std::vector<JobIterator::job_t> &g){return g.front().index==first;}),
+					pending.end());
+		}
+	}
+}
+
+/**
+ * True once no replication is running any more and the result is known.
+ */
+bool Replications::complete() const {
+	return runs.size()==dispatched && (stopped || runs.size()==total);
+}
+
+static void worker(const NetworkGraph &g, const TraceFile *trace, const TrafficMatrix *traffic,
+		const WarmStateLibrary *library, GroupMode mode) {
+	SimulationDispatcher sim(g,trace,traffic,library);
 	while(true) {
-		JobIterator::job_t mywork;
+		std::vector<JobIterator::job_t> mywork;
 		{
 			std::unique_lock<std::mutex> lck(mtx);
 			cvWorker.wait(lck,[]{return newWork;});
 			// consume:
 			mywork=std::move(nextWork);
-			if(mywork.algname.size()) newWork=false;
+			if(mywork.size()) newWork=false;
 		}
 		cvMain.notify_one();
-		if(!mywork.algname.size()) return;
+		if(!mywork.size()) return;
 		//do the work here
-		StatCounter cnt=sim.run(mywork);
+		std::vector<StatCounter> cnt;
+		if(mywork.size()==1) cnt.push_back(sim.run(mywork.front()));
+		else if(mode==CHAIN) cnt=sim.runChain(mywork);
+		else if(mode==FORK) cnt=sim.runForked(mywork);
+		else cnt=sim.runLockstep(mywork);
 		{
 			std::unique_lock<std::mutex> lck(mtx);
-			results.emplace(std::make_pair(mywork.index,std::make_pair(std::move(mywork),cnt)));
+			finished.emplace_back(std::move(mywork),std::move(cnt));
 			newResult=true;
 		}
 		cvMain.notify_one();
 	}
 }
 
+/**
+ * The largest number of fibers per link of any job.
+ */
+static unsigned long maxFibers(const std::string &opts, const std::string &algs) {
+	unsigned long result=1;
+	for(JobIterator jobs(opts,algs); !jobs.isEnd(); ++jobs) {
+		const JobIterator::job_t job=*jobs;
+		auto fibers=job.params.find("fibers");
+		if(fibers!=job.params.end()) result=std::max<unsigned long>(result,lrint(fibers->second));
+	}
+	return result;
+}
+
+/**
+ * The reason why a job with splitting ("restart") can not be run as asked,
+ * or an empty string. Splitting needs the plain main loop of a Simulation,
+ * so it does not combine with speculative provisioning or lock-step, and
+ * stopping early would cut off the retrials of the last requests. Forked
+ * jobs would split their warm-up, too.
+ */
+static std::string checkSplitting(const std::string &opts, const std::string &algs, GroupMode mode) {
+	for(JobIterator jobs(opts,algs); !jobs.isEnd(); ++jobs) {
+		const JobIterator::job_t job=*jobs;
+		auto restart=job.params.find("restart");
+		if(restart==job.params.end() || restart->second<1) continue;
+		auto parallel=job.params.find("parallel");
+		auto relci=job.params.find("relci");
+		if(mode==LOCKSTEP) return "Splitting (restart) can not be run in lock-step.";
+		if(mode==FORK) return "Splitting (restart) can not be forked.";
+		if(parallel!=job.params.end() && parallel->second>1)
+			return "Splitting (restart) can not be combined with parallel.";
+		if(relci!=job.params.end() && relci->second>0)
+			return "Splitting (restart) can not be combined with relci.";
+	}
+	return std::string();
+}
+
+/**
+ * Split the jobs into the groups that are handed to the workers.
+ * Without lock-step, every job is a group of its own. With lock-step, the
+ * jobs that can share a request stream form one group, in the order of
+ * their first job. Forked groups must also have the same number of fibers.
+ * With chained parameters, the jobs of one algorithm that only differ in
+ * those parameters form one chain, in the order of the jobs.
+ */
+static std::deque<std::vector<JobIterator::job_t> > groupJobs(JobIterator &jobs, GroupMode mode,
+		const std::set<std::string> &chained) {
+	static const char *const shared[]={"iters","discard","load","bwmin","bwmax","slots"};
+	std::deque<std::vector<JobIterator::job_t> > groups;
+	std::map<std::vector<double>,size_t> groupOf;
+	std::map<std::string,size_t> chainOf;
+	for(; !jobs.isEnd(); ++jobs) {
+		JobIterator::job_t job=*jobs;
+		if(mode==CHAIN) {
+			std::ostringstream key;
+			key<<std::setprecision(17)<<job.algname;
+			for(const auto &p:job.params)
+				if(!chained.count(p.first)) key<<';'<<p.first<<'='<<p.second;
+			auto c=chainOf.find(key.str());
+			if(c==chainOf.end()) {
+				chainOf.emplace(key.str(),groups.size());
+				groups.emplace_back(1,std::move(job));
+			} else {
+				groups[c->second].push_back(std::move(job));
+			}
+			continue;
+		}
+		if(mode==SEPARATE) {
+			groups.emplace_back(1,std::move(job));
+			continue;
+		}
+		std::vector<double> key;
+		for(const char *name:shared) {
+			auto it=job.params.find(name);
+			key.push_back(it==job.params.end()?-1:it->second);
+		}
+		if(mode==FORK) {
+			auto fibers=job.params.find("fibers");
+			key.push_back(fibers==job.params.end()?1:fibers->second);
+		}
+		auto g=groupOf.find(key);
+		if(g==groupOf.end()) {
+			groupOf.emplace(key,groups.size());
+			groups.emplace_back(1,std::move(job));
+		} else {
+			groups[g->second].push_back(std::move(job));
+		}
+	}
+	return groups;
+}
+
+/**
+ * Estimate the memory of one worker for the given jobs.
+ * A worker keeps one Simulation for each number of slots, which is sized
+ * for the largest job with that number of slots. In lock-step, it also
+ * keeps a lane for each further job of a group, so the whole group counts.
+ * A forked group keeps the snapshot besides the running job, which may
+ * have modified all of it, so its largest job counts twice.
+ */
+static StatCounter::Memory estimateWorkerMemory(const NetworkGraph &g,
+		const std::string &opts, const std::string &algs, GroupMode mode) {
+	const double avgHops=g.averageHopCount();
+	std::map<specIndex_t,StatCounter::Memory> perSimulation;
+	JobIterator jobs(opts,algs);
+	for(const auto &group:groupJobs(jobs,mode==CHAIN?SEPARATE:mode,std::set<std::string>())) {
+		StatCounter::Memory m;
+		if(mode==FORK) {
+			StatCounter::Memory largest;
+			for(const auto &job:group) {
+				const StatCounter::Memory j=SimulationDispatcher::estimateMemory(g,job,avgHops);
+				if(j.total()>largest.total()) largest=j;
+			}
+			m+=largest;
+			m+=largest;
+		} else {
+			for(const auto &job:group) m+=SimulationDispatcher::estimateMemory(g,job,avgHops);
+		}
+		StatCounter::Memory &max=perSimulation[SimulationDispatcher::getNumSlots(group.front().params)];
+		if(m.total()>max.total()) max=m;
+	}
+	StatCounter::Memory sum;
+	for(const auto &m:perSimulation) sum+=m.second;
+	return sum;
+}
+
+/**
+ * Replace the groups whose jobs ask for "reps" replications by one group
+ * per replication, and set up their bookkeeping.
+ */
+static void replicateJobs(std::deque<std::vector<JobIterator::job_t> > &groups,
+		std::map<size_t,Replications> &replicated) {
+	std::deque<std::vector<JobIterator::job_t> > expanded;
+	for(auto &group:groups) {
+		const ProvisioningSchemeBase::ParameterSet &params=group.front().params;
+		auto reps=params.find("reps");
+		if(reps==params.end() || reps->second<=1) {
+			expanded.push_back(std::move(group));
+			continue;
+		}
+		auto relci=params.find("relci");
+		Replications &r=replicated[group.front().index];
+		r.total=lrint(reps->second);
+		r.dispatched=0;
+		r.relci=relci==params.end()?0:relci->second;
+		r.stopped=false;
+		r.checked=0;
+		for(unsigned int i=0; i<r.total; ++i) {
+			expanded.push_back(group);
+			for(auto &job:expanded.back()) job.replication=i;
+		}
+	}
+	groups.swap(expanded);
+}
+
 static void printUsage(po::options_description &desc) {
 	std::cerr<<desc<<"Supported Algorithms:"<<std::endl;
 	ProvisioningSchemeFactory::getInstance().printHelp(std::cerr);
@@ -99,6 +336,33 @@ int main(int argc, char **argv) {
 	    ("skip,s", po::value<size_t>()->default_value(0),
 	    		"Skip the first n iterations."
 	    		" Useful to continue after an interruption.")
+	    ("hugepages", po::value<std::string>()->default_value("off"),
+	    		"Back the simulation state with huge pages: off, thp (transparent,"
+	    		" via madvise) or explicit (MAP_HUGETLB, falls back to thp).")
+	    ("traffic", po::value<std::string>(),
+	    		"Draw the sources, destinations and bandwidths of the requests"
+	    		" from this traffic matrix instead of uniformly.")
+	    ("trace", po::value<std::string>(),
+	    		"Replay the requests from this trace file instead of generating them.")
+	    ("record-trace", po::value<std::string>(),
+	    		"Write the requests that would be generated for the first job"
+	    		" to this trace file and exit.")
+	    ("memory-budget,m", po::value<double>()->default_value(0),
+	    		"Memory budget in MiB for all workers. Fewer threads are used"
+	    		" if the estimate exceeds it. 0 means no limit.")
+	    ("lockstep,l", "Run the algorithms that share the request parameters"
+	    		" side by side on the same requests and add paired blocking"
+	    		" differences to the output.")
+	    ("fork", "Warm up the network once for the algorithms that share the request"
+	    		" parameters and the number of fibers, and run each of them from"
+	    		" that state, discarding only \"rediscard\" requests.")
+	    ("chain", po::value<std::string>()->implicit_value("load"),
+	    		"Run the jobs that only differ in these comma separated parameters"
+	    		" one after the other, each starting from the final network state"
+	    		" of the previous one and discarding \"rediscard\" requests.")
+	    ("warm-library", po::value<std::string>(),
+	    		"Start each job from its steady state in this directory, if there"
+	    		" is one, and store the steady states of the others there.")
 	;
 	po::variables_map vm;
 	try{
@@ -110,6 +374,13 @@ int main(int argc, char **argv) {
 		printUsage(desc);
 		return -1;
 	}
+	HugePages::Mode hpMode;
+	if(!HugePages::parseMode(vm["hugepages"].as<std::string>(),hpMode)) {
+		std::cerr<<"Unknown huge page mode "<<vm["hugepages"].as<std::string>()<<std::endl;
+		printUsage(desc);
+		return -1;
+	}
+	HugePages::setMode(hpMode);
 	//set up the job iterator (parameter combinations)
 	JobIterator jobs(vm["opts"].as<std::string>(),vm["algs"].as<std::string>());
 
@@ -140,6 +411,96 @@ int main(int argc, char **argv) {
 	NetworkGraph g=NetworkGraph::loadFromMatrix(*instream);
 	if(infile.is_open()) infile.close();
 
+	//all fibers of all links are numbered with one linkIndex_t
+	const unsigned long fibers=maxFibers(vm["opts"].as<std::string>(),vm["algs"].as<std::string>());
+	if(fibers*num_edges(g.g)>std::numeric_limits<linkIndex_t>::max()) {
+		std::cerr<<"The network has "<<num_edges(g.g)<<" links, so it supports at most "
+			<<std::numeric_limits<linkIndex_t>::max()/num_edges(g.g)<<" fibers per link."<<std::endl;
+		return -1;
+	}
+	if(vm.count("lockstep")+vm.count("fork")+vm.count("chain")>1) {
+		std::cerr<<"Only one of lockstep, fork and chain can be used."<<std::endl;
+		return -1;
+	}
+	const GroupMode mode=vm.count("lockstep")?LOCKSTEP:vm.count("fork")?FORK:vm.count("chain")?CHAIN:SEPARATE;
+	const std::string splitError=checkSplitting(vm["opts"].as<std::string>(),vm["algs"].as<std::string>(),mode);
+	if(!splitError.empty()) {
+		std::cerr<<splitError<<std::endl;
+		return -1;
+	}
+
+	//load the traffic matrix, keeping its contents for the warm state library
+	std::unique_ptr<const TrafficMatrix> traffic;
+	std::string trafficContents;
+	if(vm.count("traffic")) {
+		std::ifstream trafficFile(vm["traffic"].as<std::string>());
+		try {
+			if(!trafficFile)
+				throw std::runtime_error("Can not open the traffic matrix "+vm["traffic"].as<std::string>());
+			trafficContents.assign(std::istreambuf_iterator<char>(trafficFile),std::istreambuf_iterator<char>());
+			std::istringstream trafficStream(trafficContents);
+			traffic.reset(new TrafficMatrix(trafficStream));
+		} catch(std::runtime_error &e) {
+			std::cerr<<e.what()<<std::endl;
+			return -1;
+		}
+		if(traffic->getNumNodes()!=num_vertices(g.g)) {
+			std::cerr<<"The traffic matrix is for "<<traffic->getNumNodes()
+				<<" nodes, but the network has "<<num_vertices(g.g)<<'.'<<std::endl;
+			return -1;
+		}
+	}
+
+	//record a trace, or map the trace to replay
+	if(vm.count("record-trace")) {
+		TraceWriter::generate(vm["record-trace"].as<std::string>(),num_vertices(g.g),(*jobs).params,
+				traffic.get());
+		return 0;
+	}
+	std::unique_ptr<const TraceFile> trace;
+	if(vm.count("trace")) {
+		try {
+			trace.reset(new TraceFile(vm["trace"].as<std::string>()));
+		} catch(std::runtime_error &e) {
+			std::cerr<<e.what()<<std::endl;
+			return -1;
+		}
+		if(trace->getNumNodes()>num_vertices(g.g)) {
+			std::cerr<<"The trace has requests for "<<trace->getNumNodes()
+				<<" nodes, but the network only has "<<num_vertices(g.g)<<'.'<<std::endl;
+			return -1;
+		}
+		std::cerr<<"Replaying "<<trace->getNumRecords()<<" requests from the trace."<<std::endl;
+	}
+
+	//the parameters to chain over
+	std::set<std::string> chained;
+	if(vm.count("chain")) {
+		std::istringstream names(vm["chain"].as<std::string>());
+		for(std::string name; std::getline(names,name,',');) {
+			if(name=="slots" || name=="fibers") {
+				std::cerr<<"The number of "<<name<<" can not be chained."<<std::endl;
+				return -1;
+			}
+			if(!name.empty()) chained.insert(name);
+		}
+	}
+
+	//open the warm state library
+	std::unique_ptr<const WarmStateLibrary> library;
+	if(vm.count("warm-library")) {
+		if(trace || mode==LOCKSTEP || mode==FORK) {
+			std::cerr<<"The warm state library is not used for traces, in lock-step or with fork."<<std::endl;
+		} else {
+			try {
+				library.reset(new WarmStateLibrary(vm["warm-library"].as<std::string>(),g,trafficContents));
+			} catch(std::runtime_error &e) {
+				std::cerr<<e.what()<<std::endl;
+				return -1;
+			}
+		}
+	}
+
 	//send the output to a file or stdout
 	std::ofstream outfile;
 	std::ostream *outstream=&std::cout;
@@ -148,46 +509,103 @@ int main(int argc, char **argv) {
 		outstream=&outfile;
 	}
 
+	//estimate the memory before starting the workers
+	size_t numThreads=vm["threads"].as<size_t>();
+	const StatCounter::Memory perWorker=estimateWorkerMemory(g,
+			vm["opts"].as<std::string>(),vm["algs"].as<std::string>(),mode);
+	std::cerr<<"Estimated memory per worker: "<<perWorker<<std::endl;
+	const double budget=vm["memory-budget"].as<double>()*(1<<20);
+	if(budget>0 && numThreads*perWorker.total()>budget) {
+		numThreads=budget/perWorker.total();
+		if(numThreads==0) {
+			std::cerr<<"A single worker exceeds the memory budget."<<std::endl;
+			return -1;
+		}
+		std::cerr<<"Reducing to "<<numThreads<<" threads to stay within the memory budget."<<std::endl;
+	}
+
 	std::cerr<<std::thread::hardware_concurrency()
-		<<" Threads supported; using "<<vm["threads"].as<size_t>()<<'.'
+		<<" Threads supported; using "<<numThreads<<'.'
 		<<std::endl;
-	std::vector<std::thread> threadPool(vm["threads"].as<size_t>());
-	for(auto &t:threadPool) t=std::thread(worker,std::ref(g));
+	std::vector<std::thread> threadPool(numThreads);
+	for(auto &t:threadPool)
+		t=std::thread(worker,std::ref(g),trace.get(),traffic.get(),library.get(),mode);
 
 	size_t resultIdx=jobs.getCurrentIteration();
-	std::string lastAlg("");
-	while(!jobs.isEnd() || resultIdx<jobs.getCurrentIteration()) {
+	std::deque<std::vector<JobIterator::job_t> > pending=groupJobs(jobs,mode,chained);
+	std::map<size_t,Replications> replicated;
+	replicateJobs(pending,replicated);
+	std::map<size_t,std::pair<JobIterator::job_t,const StatCounter>> results;
+	std::string lastHeader("");
+	while(!pending.empty() || resultIdx<jobs.getTotalIterations()) {
 		bool printProgress=false;
 		{
 			std::unique_lock<std::mutex> lck(mtx);
 			cvMain.wait(lck,[]{return !newWork || newResult;});
 			if(!newWork) {
-				nextWork=*jobs;
-				++jobs;
+				if(pending.empty()) {
+					nextWork.clear();
+				} else {
+					nextWork=std::move(pending.front());
+					pending.pop_front();
+					auto r=replicated.find(nextWork.front().index);
+					if(r!=replicated.end()) ++r->second.dispatched;
+				}
 				newWork=true;
 			}
 			if(newResult) {
+				for(auto &f:finished) {
+					const size_t first=f.first.front().index;
+					auto r=replicated.find(first);
+					if(r==replicated.end()) {
+						for(size_t i=0; i<f.first.size(); ++i)
+							results.emplace(std::make_pair(f.first[i].index,
+									std::make_pair(std::move(f.first[i]),f.second[i])));
+						continue;
+					}
+					Replications &rep=r->second;
+					rep.runs.emplace(f.first.front().replication,std::move(f.second));
+					rep.check(pending,first);
+					if(rep.complete()) {
+						const std::vector<StatCounter> merged=rep.merge(rep.checked);
+						for(size_t i=0; i<f.first.size(); ++i)
+							results.emplace(std::make_pair(f.first[i].index,
+									std::make_pair(std::move(f.first[i]),merged[i])));
+						replicated.erase(r);
+					}
+				}
+				finished.clear();
 				for(auto it=results.begin();
 						it!=results.end() && it->first==resultIdx;
 						++it, ++resultIdx, results.erase(std::prev(it)) ) {
-					if(lastAlg!=it->second.first.algname) {
-						*outstream << '#' << it->second.first.algname << ':';
-						for(const auto &pn:it->second.first.params)
-							*outstream << pn.first << TABLE_COL_SEPARATOR;
-						*outstream<<it->second.second.tableHeader<<std::endl;
-						lastAlg=it->second.first.algname;
+					std::ostringstream header;
+					header << '#' << it->second.first.algname << ':';
+					for(const auto &pn:it->second.first.params)
+						header << pn.first << TABLE_COL_SEPARATOR;
+					it->second.second.printTableHeader(header);
+					if(lastHeader!=header.str()) {
+						lastHeader=header.str();
+						*outstream << lastHeader << std::endl;
 					}
 					for(const auto &pn:it->second.first.params)
 						*outstream<<pn.second << TABLE_COL_SEPARATOR;
 					*outstream << it->second.second <<std::endl;
+					auto memReport=it->second.first.params.find("memreport");
+					if(memReport!=it->second.first.params.end() && memReport->second
+							&& it->second.second.hasMemory()) {
+						std::cerr<<"Memory of "<<it->second.first.algname<<" (job "<<it->first<<")"
+							<<"\n  start: "<<it->second.second.getMemoryStart()
+							<<"\n  peak:  "<<it->second.second.getMemoryPeak()<<std::endl;
+					}
 					printProgress=true;
 				}
 				newResult=false;
 			}
 		}
-		if(jobs.isEnd()) cvWorker.notify_all();
+		if(pending.empty()) cvWorker.notify_all();
 		else cvWorker.notify_one();
 		if(printProgress) {
+			HugePages::sample();
 			outstream->flush();
 			std::cerr<<'['<<std::setw(3)<<resultIdx*100/jobs.getTotalIterations()<<std::setw(0)<<"%] "
 					<<resultIdx<<" / "<<jobs.getTotalIterations()<<" done."<<std::endl;
@@ -195,6 +613,7 @@ int main(int argc, char **argv) {
 	}
 	//wait for all threads to finish
 	for(auto &t:threadPool) t.join();
+	if(hpMode!=HugePages::OFF) HugePages::printReport(std::cerr);
 
 	return 0;
 }
@@ -22,14 +22,17 @@
 
 #include "Chen2013MFSBProvisioning.h"
 
+#include "../PhaseTimer.h"
 #include "../SimulationMsgs.h"
 #include "ProvisioningSchemeFactory.h"
 
 /// by construction, this registers the class in the ProvisioningSchemeFactory factory.
 static const ProvisioningSchemeFactory::Registrar<Chen2013MFSBProvisioning> _reg("mfsb");
-const char *const Chen2013MFSBProvisioning::helpstr=
+template<specIndex_t numSlots>
+const char *const Chen2013MFSBProvisioning<numSlots>::helpstr=
 		"The Minimum Free Spectrum Block heuristic";
-const ProvisioningScheme::paramDesc_t Chen2013MFSBProvisioning::pdesc[]={
+template<specIndex_t numSlots>
+const ProvisioningSchemeBase::paramDesc_t Chen2013MFSBProvisioning<numSlots>::pdesc[]={
 		{"k",      "0<k",      XSTR(DEFAULT_K),
 				"Default value for k_pri and k_bkp"},
 		{"k_pri",  "0<k_pri",  "k",
@@ -39,9 +42,11 @@ const ProvisioningScheme::paramDesc_t Chen2013MFSBProvisioning::pdesc[]={
 		{0,0,0,0}
 };
 
-Chen2013MFSBProvisioning::Chen2013MFSBProvisioning(const ProvisioningScheme::ParameterSet &p):
+template<specIndex_t numSlots>
+Chen2013MFSBProvisioning<numSlots>::Chen2013MFSBProvisioning(const ProvisioningSchemeBase::ParameterSet &p):
 k_pri(DEFAULT_K),
-k_bkp(DEFAULT_K)
+k_bkp(DEFAULT_K),
+protection()
 {
 	auto it=p.find("k");
 	if(it!=p.end())
@@ -54,11 +59,13 @@ k_bkp(DEFAULT_K)
 		k_bkp=lrint(it->second);
 }
 
-Chen2013MFSBProvisioning::~Chen2013MFSBProvisioning() {
+template<specIndex_t numSlots>
+Chen2013MFSBProvisioning<numSlots>::~Chen2013MFSBProvisioning() {
 }
 
-Provisioning Chen2013MFSBProvisioning::operator ()(const NetworkGraph& g,
-		const NetworkState& s, const NetworkGraph::DijkstraData &data, const Request& r) {
+template<specIndex_t numSlots>
+Provisioning Chen2013MFSBProvisioning<numSlots>::operator ()(const NetworkGraph& g,
+		const NetworkState<numSlots>& s, const NetworkGraph::DijkstraData &data, const Request& r) {
 	Provisioning result;
 	result.bandwidth=r.bandwidth;
 	result.priSpecEnd=0;
@@ -67,11 +74,13 @@ Provisioning Chen2013MFSBProvisioning::operator ()(const NetworkGraph& g,
 	NetworkGraph::YenKShortestSearch y(g,r.source,r.dest,data);
 	{
 		const std::vector<NetworkGraph::Path> &priPaths=y.getPaths(k_pri);
+		typename NetworkState<numSlots>::TrieAvailability priAvail(s,y.getTrie(k_pri));
 		if(priPaths.empty()) {
 			result.state=Provisioning::BLOCK_PRI_NOPATH;
 			return result;
 		}
-		for(auto const &p:priPaths) {
+		for(size_t pi=0; pi<priPaths.size(); ++pi) {
+			const NetworkGraph::Path &p=priPaths[pi];
 			distance_t len=0;
 			for(auto const &e:p) len+=data.weights[e.idx];
 
@@ -82,18 +91,9 @@ Provisioning Chen2013MFSBProvisioning::operator ()(const NetworkGraph& g,
 			}
 			specIndex_t neededSpec=calcNumSlots(r.bandwidth,result.priMod);
 
-			const NetworkState::spectrum_bits spec=s.priAvailability(p);
-
-			specIndex_t count=0;
-			for(specIndex_t i=0; i<NUM_SLOTS; ++i) {
-				if(spec[i]) count=0;
-				else if(++count==neededSpec) {
-					result.priSpecBegin=i-count+1;
-					result.priSpecEnd=i+1;
-					break;
-				}
-			}
-			if(result.priSpecEnd) {
+			//first-fit over all fibers
+			if(priAvail.firstFit(pi,neededSpec,result.priFiber,result.priSpecBegin)) {
+				result.priSpecEnd=result.priSpecBegin+neededSpec;
 				result.priPath=p;
 				break;
 			}
@@ -111,10 +111,12 @@ Provisioning Chen2013MFSBProvisioning::operator ()(const NetworkGraph& g,
 	for(auto const &e:result.priPath) data.weights[e.idx]=std::numeric_limits<distance_t>::max();
 	const std::vector<NetworkGraph::Path> &bkpPaths=y.getPaths(k_bkp);
 	for(auto const &e:result.priPath) data.weights[e.idx]=g.link_lengths[e.idx];
+	protection.setPrimary(s,result.priPath);
 	if(bkpPaths.empty()) {
 		result.state=Provisioning::BLOCK_SEC_NOPATH;
 		return result;
 	}
+	PHASE_SCOPE(COST);
 	for(auto const &p:bkpPaths) {
 		distance_t len=0;
 		for(auto const &e:p) len+=data.weights[e.idx];
@@ -123,24 +125,24 @@ Provisioning Chen2013MFSBProvisioning::operator ()(const NetworkGraph& g,
 		if(mod==MOD_NONE) break;
 		specIndex_t neededSpec=calcNumSlots(r.bandwidth,mod);
 
-		const NetworkState::spectrum_bits spec=s.bkpAvailability(result.priPath,p);
-
-		specIndex_t count=0;
-		specIndex_t fsb=0;
-		for(specIndex_t i=0; i<NUM_SLOTS; ++i) {
-			if(spec[i]) {
-				count=0;
-				fsb=0;
-			} else {
-				fsb+=s.countFreeBlocks(p,i);
-				++count;
-				if(count> neededSpec) fsb-=s.countFreeBlocks(p,i-neededSpec);
-				if(count>=neededSpec && fsb<bestFSB) {
-					bestFSB=fsb;
-					bestPath=&p;
-					result.bkpSpecBegin=i-neededSpec+1;
-					result.bkpSpecEnd=i+1;
-					result.bkpMod=mod;
+		for(fiberIndex_t f=0; f<s.getNumFibers(); ++f) {
+			const typename NetworkState<numSlots>::spectrum_bits spec=protection.bkpAvailability(p,f);
+			const typename NetworkState<numSlots>::free_blocks_t freeBlocks=s.freeBlockTable(p,f);
+
+			specIndex_t count=0;
+			for(specIndex_t i=0; i<numSlots; ++i) {
+				if(spec[i]) {
+					count=0;
+				} else if(++count>=neededSpec) {
+					const specIndex_t fsb=freeBlocks[i+1]-freeBlocks[i+1-neededSpec];
+					if(fsb<bestFSB) {
+						bestFSB=fsb;
+						bestPath=&p;
+						result.bkpFiber=f;
+						result.bkpSpecBegin=i-neededSpec+1;
+						result.bkpSpecEnd=i+1;
+						result.bkpMod=mod;
+					}
 				}
 			}
 		}
@@ -154,10 +156,15 @@ Provisioning Chen2013MFSBProvisioning::operator ()(const NetworkGraph& g,
 	return result;
 }
 
-std::ostream& Chen2013MFSBProvisioning::print(std::ostream& o) const {
-	return printFormatted(o,helpstr,pdesc);
+template<specIndex_t numSlots>
+std::ostream& Chen2013MFSBProvisioning<numSlots>::print(std::ostream& o) const {
+	return this->printFormatted(o,helpstr,pdesc);
 }
 
-ProvisioningScheme* Chen2013MFSBProvisioning::clone() {
+template<specIndex_t numSlots>
+ProvisioningScheme<numSlots>* Chen2013MFSBProvisioning<numSlots>::clone() {
 	return new Chen2013MFSBProvisioning(*this);
 }
+
+#define INSTANTIATE_CHEN2013MFSBPROVISIONING(n) template class Chen2013MFSBProvisioning<n>;
+FOR_EACH_NUM_SLOTS(INSTANTIATE_CHEN2013MFSBPROVISIONING)
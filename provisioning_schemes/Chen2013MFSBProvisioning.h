@@ -29,18 +29,20 @@
 /**
  * \brief Implementation of the MFSB Heuristic.
  */
-class Chen2013MFSBProvisioning: public ProvisioningScheme {
+template<specIndex_t numSlots>
+class Chen2013MFSBProvisioning: public ProvisioningScheme<numSlots> {
 public:
-	Chen2013MFSBProvisioning(const ParameterSet &p);
+	Chen2013MFSBProvisioning(const ProvisioningSchemeBase::ParameterSet &p);
 	virtual ~Chen2013MFSBProvisioning();
-	virtual ProvisioningScheme *clone();
-	virtual Provisioning operator()(const NetworkGraph &g, const NetworkState &s, const NetworkGraph::DijkstraData &data, const Request &r);
+	virtual ProvisioningScheme<numSlots> *clone();
+	virtual Provisioning operator()(const NetworkGraph &g, const NetworkState<numSlots> &s, const NetworkGraph::DijkstraData &data, const Request &r);
 protected:
 	virtual std::ostream& print(std::ostream &o) const;
 private:
 	static const char *const helpstr;
-	static const paramDesc_t pdesc[];
+	static const ProvisioningSchemeBase::paramDesc_t pdesc[];
 	unsigned int k_pri, k_bkp;
+	typename NetworkState<numSlots>::ProtectionRows protection;
 };
 
 #endif /* CHEN2013MFSBPROVISIONING_H_ */
@@ -21,15 +21,18 @@
  */
 
 #include "KsqHybridCost2Provisioning.h"
+#include "../PhaseTimer.h"
 #include "ProvisioningSchemeFactory.h"
 
 #define DEFAULT_WEIGHT 1.0
 
 /// by construction, this registers the class in the ProvisioningSchemeFactory factory.
 static const ProvisioningSchemeFactory::Registrar<KsqHybridCost2Provisioning> _reg("ksq");
-const char *const KsqHybridCost2Provisioning::helpstr=
+template<specIndex_t numSlots>
+const char *const KsqHybridCost2Provisioning<numSlots>::helpstr=
 		"The k-squared hybrid heuristic (separate cost metrics)";
-const ProvisioningScheme::paramDesc_t KsqHybridCost2Provisioning::pdesc[]={
+template<specIndex_t numSlots>
+const ProvisioningSchemeBase::paramDesc_t KsqHybridCost2Provisioning<numSlots>::pdesc[]={
 		{"k",      "0<k",      XSTR(DEFAULT_K),
 				"Default value for k_pri and k_bkp"},
 		{"k_pri",  "0<k_pri",  "k",
@@ -42,11 +45,14 @@ const ProvisioningScheme::paramDesc_t KsqHybridCost2Provisioning::pdesc[]={
 				"Weight of the \"Misalignment\" metric"},
 		{"c_fsb",  "0<=c_fsb", XSTR(DEFAULT_WEIGHT),
 				"Weight of the \"free spectrum block\" metric"},
+		{"lookahead", "{0,1}", "0",
+				"Score the backups with the primary tentatively provisioned"},
 		{0,0,0,0}
 };
 
-KsqHybridCost2Provisioning::KsqHybridCost2Provisioning(
-		const ProvisioningScheme::ParameterSet &p
+template<specIndex_t numSlots>
+KsqHybridCost2Provisioning<numSlots>::KsqHybridCost2Provisioning(
+		const ProvisioningSchemeBase::ParameterSet &p
 ):
 		k_pri(DEFAULT_K),
 		k_bkp(DEFAULT_K),
@@ -57,7 +63,10 @@ KsqHybridCost2Provisioning::KsqHybridCost2Provisioning(
 #endif
 		c_cut(DEFAULT_WEIGHT),
 		c_algn(DEFAULT_WEIGHT),
-		c_fsb(DEFAULT_WEIGHT)
+		c_fsb(DEFAULT_WEIGHT),
+		lookahead(false),
+		protection(),
+		overlay()
 {
 	auto it=p.find("k");
 	if(it!=p.end())	k_pri=k_bkp=lrint(it->second);
@@ -77,13 +86,17 @@ KsqHybridCost2Provisioning::KsqHybridCost2Provisioning(
 	it=p.find("c_fsb");
 	if(it!=p.end())	c_fsb=it->second;
 
+	it=p.find("lookahead");
+	if(it!=p.end())	lookahead=it->second!=0;
+
 #ifdef TEST_METRICS
 	it=p.find("discard");
 	if(it!=p.end())	n=0-lrint(it->second);
 #endif
 }
 
-KsqHybridCost2Provisioning::~KsqHybridCost2Provisioning() {
+template<specIndex_t numSlots>
+KsqHybridCost2Provisioning<numSlots>::~KsqHybridCost2Provisioning() {
 #ifdef TEST_METRICS
 	std::cerr<<"Primary: "
 			<< mpsum.m_sep/n <<"; "<< mpsum.m_algn/n <<"; "
@@ -94,8 +107,9 @@ KsqHybridCost2Provisioning::~KsqHybridCost2Provisioning() {
 #endif
 }
 
-Provisioning KsqHybridCost2Provisioning::operator ()(
-		const NetworkGraph& g, const NetworkState& s, const NetworkGraph::DijkstraData &data,
+template<specIndex_t numSlots>
+Provisioning KsqHybridCost2Provisioning<numSlots>::operator ()(
+		const NetworkGraph& g, const NetworkState<numSlots>& s, const NetworkGraph::DijkstraData &data,
 		const Request& r) {
 #ifdef TEST_METRICS
 	metricvals_t mp={0}, mb={0}, mpopt={0}, mbopt={0};
@@ -107,80 +121,109 @@ Provisioning KsqHybridCost2Provisioning::operator ()(
 
 	NetworkGraph::YenKShortestSearch y(g,r.source,r.dest,data);
 	const std::vector<NetworkGraph::Path> priPaths=y.getPaths(k_pri);
-	for(auto const &pp:priPaths) {
+	const NetworkGraph::PathTrie priTrie=y.getTrie(k_pri);
+	typename NetworkState<numSlots>::TrieAvailability priAvail(s,priTrie);
+	if(lookahead) overlay.attach(s);
+	for(size_t pi=0; pi<priPaths.size(); ++pi) {
+		//the searches within are charged to their own phases
+		PHASE_SCOPE(COST);
+		const NetworkGraph::Path &pp=priPaths[pi];
 		distance_t lenp=0;
 		for(auto const &e:pp) lenp+=data.weights[e.idx];
 		const modulation_t modp=calcModulation(lenp);
 		const specIndex_t widthp=calcNumSlots(r.bandwidth,modp);
-		const NetworkState::spectrum_bits specp=s.priAvailability(pp);
-
 		double coptp=std::numeric_limits<double>::infinity();
-		specIndex_t usedp=0;
-		specIndex_t ip=NUM_SLOTS;
-		for(specIndex_t i=0; i<widthp-1; ++i)
-			if(specp[i]) ++usedp;
-		for(specIndex_t i=0; i<=NUM_SLOTS-widthp; ++i) {
-			if(specp[i+widthp-1]) ++usedp;
-			if(!usedp) {
-				double c;
+		specIndex_t ip=numSlots;
+		fiberIndex_t fp=0;
+		for(fiberIndex_t f=0; f<s.getNumFibers(); ++f) {
+			const typename NetworkState<numSlots>::spectrum_bits specp=priAvail.priAvailability(pi,f);
+			specIndex_t usedp=0;
+			for(specIndex_t i=0; i<widthp-1; ++i)
+				if(specp[i]) ++usedp;
+			for(specIndex_t i=0; i<=numSlots-widthp; ++i) {
+				if(specp[i+widthp-1]) ++usedp;
+				if(!usedp) {
+					double c;
 #ifdef TEST_METRICS
-				c=costp(g,s,pp,i,i+widthp,mp);
+					c=costp(g,s,pp,f,i,i+widthp,mp);
 #else
-				c=costp(g,s,pp,i,i+widthp);
+					c=costp(g,s,pp,f,i,i+widthp);
 #endif
-				if(c<coptp) {
-					ip=i;
-					coptp=c;
+					if(c<coptp) {
+						ip=i;
+						fp=f;
+						coptp=c;
+					}
 				}
+				if(specp[i]) --usedp;
 			}
-			if(specp[i]) --usedp;
 		}
-		if(ip==NUM_SLOTS || coptp>copt) continue;
+		if(ip==numSlots || coptp>copt) continue;
 
 		y.reset();
 		for(auto const &e:pp) data.weights[e.idx]=std::numeric_limits<distance_t>::max();
 		const std::vector<NetworkGraph::Path> &bkpPaths=y.getPaths(k_bkp);
 		for(auto const &e:pp) data.weights[e.idx]=g.link_lengths[e.idx];
+		protection.setPrimary(s,pp);
+		//the backup metrics see the primary's slots at the shared nodes
+		Provisioning trial;
+		if(lookahead) {
+			trial.bandwidth=r.bandwidth;
+			trial.priPath=pp;
+			trial.priFiber=fp;
+			trial.priSpecBegin=ip;
+			trial.priSpecEnd=ip+widthp;
+			trial.priMod=modp;
+			trial.bkpSpecBegin=0;
+			trial.bkpSpecEnd=0;
+		}
+		const NetworkState<numSlots> &sb=lookahead?overlay.tryProvision(trial):s;
 
 		for(auto const &pb:bkpPaths) {
 			distance_t lenb=0;
 			for(auto const &e:pb) lenb+=data.weights[e.idx];
 			const modulation_t modb=calcModulation(lenb);
 			const specIndex_t widthb=calcNumSlots(r.bandwidth,modb);
-			const NetworkState::spectrum_bits specb=s.bkpAvailability(pp,pb);
+			for(fiberIndex_t f=0; f<s.getNumFibers(); ++f) {
+				const typename NetworkState<numSlots>::spectrum_bits specb=protection.bkpAvailability(pb,f);
+				const typename NetworkState<numSlots>::free_blocks_t freeb=sb.freeBlockTable(pb,f);
 
-			specIndex_t usedb=0;
-			for(specIndex_t ib=0; ib<widthb-1; ++ib)
-				if(specb[ib]) ++usedb;
-			for(specIndex_t ib=0; ib<=NUM_SLOTS-widthb; ++ib) {
-				if(specb[ib+widthb-1]) ++usedb;
-				if(!usedb) {
-					double c;
+				specIndex_t usedb=0;
+				for(specIndex_t ib=0; ib<widthb-1; ++ib)
+					if(specb[ib]) ++usedb;
+				for(specIndex_t ib=0; ib<=numSlots-widthb; ++ib) {
+					if(specb[ib+widthb-1]) ++usedb;
+					if(!usedb) {
+						double c;
 #ifdef TEST_METRICS
-					c=coptp+costb(g,s,pb,ib,ib+widthb,mb);
+						c=coptp+costb(g,sb,pb,freeb,f,ib,ib+widthb,mb);
 #else
-					c=coptp+costb(g,s,pb,ib,ib+widthb);
+						c=coptp+costb(g,sb,pb,freeb,f,ib,ib+widthb);
 #endif
-					if(c<copt) {
-						result.state=Provisioning::SUCCESS;
-						result.priPath=pp;
-						result.priSpecBegin=ip;
-						result.priSpecEnd=ip+widthp;
-						result.priMod=modp;
-						result.bkpPath=pb;
-						result.bkpSpecBegin=ib;
-						result.bkpSpecEnd=ib+widthb;
-						result.bkpMod=modb;
-						copt=c;
+						if(c<copt) {
+							result.state=Provisioning::SUCCESS;
+							result.priPath=pp;
+							result.priFiber=fp;
+							result.priSpecBegin=ip;
+							result.priSpecEnd=ip+widthp;
+							result.priMod=modp;
+							result.bkpPath=pb;
+							result.bkpFiber=f;
+							result.bkpSpecBegin=ib;
+							result.bkpSpecEnd=ib+widthb;
+							result.bkpMod=modb;
+							copt=c;
 #ifdef TEST_METRICS
-						mpopt=mp;
-						mbopt=mb;
+							mpopt=mp;
+							mbopt=mb;
 #endif
+						}
 					}
+					if(specb[ib]) --usedb;
 				}
-				if(specb[ib]) --usedb;
 			}
 		}
+		if(lookahead) overlay.undo();
 	}
 #ifdef TEST_METRICS
 	++n;
@@ -198,59 +241,69 @@ Provisioning KsqHybridCost2Provisioning::operator ()(
 	return result;
 }
 
-std::ostream& KsqHybridCost2Provisioning::print(std::ostream& o) const {
-	return printFormatted(o,helpstr,pdesc);
+template<specIndex_t numSlots>
+std::ostream& KsqHybridCost2Provisioning<numSlots>::print(std::ostream& o) const {
+	return this->printFormatted(o,helpstr,pdesc);
 }
 
 #ifdef TEST_METRICS
 
-inline double KsqHybridCost2Provisioning::costp(const NetworkGraph& g,
-		const NetworkState& s, const NetworkGraph::Path& pp, specIndex_t beginp,
+template<specIndex_t numSlots>
+inline double KsqHybridCost2Provisioning<numSlots>::costp(const NetworkGraph& g,
+		const NetworkState<numSlots>& s, const NetworkGraph::Path& pp, fiberIndex_t fiber, specIndex_t beginp,
 		specIndex_t endp, metricvals_t &m) const {
 	m.m_fsb=pp.size()*(endp-beginp);
-	m.m_cut=s.calcCuts(g,pp,beginp,endp);
-	m.m_algn=s.calcMisalignments(g,pp,beginp,endp);
+	m.m_cut=s.calcCuts(g,pp,beginp,endp,fiber);
+	m.m_algn=s.calcMisalignments(g,pp,beginp,endp,fiber);
 	m.m_sep=beginp*pp.size();
 	return    c_cut  * m.m_cut
 			+ c_algn * m.m_algn
 			+          m.m_sep;
 	/*
-	return	 c_cut *(         s.calcCuts(g,pp,beginp,endp))
-			+c_algn*(s.calcMisalignments(g,pp,beginp,endp))
+	return	 c_cut *(         s.calcCuts(g,pp,beginp,endp,fiber))
+			+c_algn*(s.calcMisalignments(g,pp,beginp,endp,fiber))
 			+       beginp*pp.size();
 	*/
 }
 
-inline double KsqHybridCost2Provisioning::costb(const NetworkGraph& g,
-		const NetworkState& s, const NetworkGraph::Path& pb, specIndex_t beginb,
+template<specIndex_t numSlots>
+inline double KsqHybridCost2Provisioning<numSlots>::costb(const NetworkGraph& g,
+		const NetworkState<numSlots>& s, const NetworkGraph::Path& pb,
+		const typename NetworkState<numSlots>::free_blocks_t &freeb, fiberIndex_t fiber, specIndex_t beginb,
 		specIndex_t endb, metricvals_t &m) const {
-	m.m_fsb=s.countFreeBlocks(pb,beginb,endb);
-	m.m_cut=s.calcCuts(g,pb,beginb,endb);
-	m.m_algn=s.calcMisalignments(g,pb,beginb,endb);
-	m.m_sep=(NUM_SLOTS-endb)*pb.size();
+	m.m_fsb=freeb[endb]-freeb[beginb];
+	m.m_cut=s.calcCuts(g,pb,beginb,endb,fiber);
+	m.m_algn=s.calcMisalignments(g,pb,beginb,endb,fiber);
+	m.m_sep=(numSlots-endb)*pb.size();
 	return    c_fsb  * m.m_fsb
 			+          m.m_sep;
 	/*
-	return	 c_fsb *(    s.countFreeBlocks(pb,beginb,endb))
-			+       (NUM_SLOTS-endb)*pb.size();
+	return	 c_fsb *(    s.countFreeBlocks(pb,beginb,endb,fiber))
+			+       (numSlots-endb)*pb.size();
 	*/
 }
 
 #else
 
-inline double KsqHybridCost2Provisioning::costp(const NetworkGraph& g,
-		const NetworkState& s, const NetworkGraph::Path& pp, specIndex_t beginp,
+template<specIndex_t numSlots>
+inline double KsqHybridCost2Provisioning<numSlots>::costp(const NetworkGraph& g,
+		const NetworkState<numSlots>& s, const NetworkGraph::Path& pp, fiberIndex_t fiber, specIndex_t beginp,
 		specIndex_t endp) const {
-	return	 c_cut *(         s.calcCuts(g,pp,beginp,endp))
-			+c_algn*(s.calcMisalignments(g,pp,beginp,endp))
+	return	 c_cut *(         s.calcCuts(g,pp,beginp,endp,fiber))
+			+c_algn*(s.calcMisalignments(g,pp,beginp,endp,fiber))
 			+       beginp*pp.size();
 }
 
-inline double KsqHybridCost2Provisioning::costb(const NetworkGraph& g,
-		const NetworkState& s, const NetworkGraph::Path& pb, specIndex_t beginb,
+template<specIndex_t numSlots>
+inline double KsqHybridCost2Provisioning<numSlots>::costb(const NetworkGraph& g,
+		const NetworkState<numSlots>& s, const NetworkGraph::Path& pb,
+		const typename NetworkState<numSlots>::free_blocks_t &freeb, fiberIndex_t fiber, specIndex_t beginb,
 		specIndex_t endb) const {
-	return	 c_fsb *(    s.countFreeBlocks(pb,beginb,endb))
-			+       (NUM_SLOTS-endb)*pb.size();
+	return	 c_fsb *(    freeb[endb]-freeb[beginb])
+			+       (numSlots-endb)*pb.size();
 }
 
 #endif
+
+#define INSTANTIATE_KSQHYBRIDCOST2PROVISIONING(n) template class KsqHybridCost2Provisioning<n>;
+FOR_EACH_NUM_SLOTS(INSTANTIATE_KSQHYBRIDCOST2PROVISIONING)
@@ -35,16 +35,17 @@
 /**
  * \brief Implementation of the $k^2$ shortest path heuristic with hybrid cost metric.
  */
-class KsqHybridCost2Provisioning: public ProvisioningScheme {
+template<specIndex_t numSlots>
+class KsqHybridCost2Provisioning: public ProvisioningScheme<numSlots> {
 public:
-	KsqHybridCost2Provisioning(const ParameterSet &p);
+	KsqHybridCost2Provisioning(const ProvisioningSchemeBase::ParameterSet &p);
 	virtual ~KsqHybridCost2Provisioning();
-	virtual Provisioning operator()(const NetworkGraph &g, const NetworkState &s, const NetworkGraph::DijkstraData &data, const Request &r);
+	virtual Provisioning operator()(const NetworkGraph &g, const NetworkState<numSlots> &s, const NetworkGraph::DijkstraData &data, const Request &r);
 protected:
 	virtual std::ostream& print(std::ostream &o) const;
 private:
 	static const char *const helpstr;
-	static const paramDesc_t pdesc[];
+	static const ProvisioningSchemeBase::paramDesc_t pdesc[];
 	unsigned int k_pri; ///< Number of paths to consider for the primary
 	unsigned int k_bkp; ///< Number of paths to consider for backup, per primary
 #ifdef TEST_METRICS
@@ -53,17 +54,23 @@ private:
 	} metricvals_t;
 	int64_t n;
 	metricvals_t mpsum, mbsum;
-	double costp(const NetworkGraph &g, const NetworkState &s,
-			const NetworkGraph::Path &pp, specIndex_t beginp, specIndex_t endp, metricvals_t &m) const;
-	double costb(const NetworkGraph &g, const NetworkState &s,
-			const NetworkGraph::Path &pb, specIndex_t beginb, specIndex_t endb, metricvals_t &m) const;
+	double costp(const NetworkGraph &g, const NetworkState<numSlots> &s,
+			const NetworkGraph::Path &pp, fiberIndex_t fiber, specIndex_t beginp, specIndex_t endp, metricvals_t &m) const;
+	double costb(const NetworkGraph &g, const NetworkState<numSlots> &s,
+			const NetworkGraph::Path &pb, const typename NetworkState<numSlots>::free_blocks_t &freeb,
+			fiberIndex_t fiber, specIndex_t beginb, specIndex_t endb, metricvals_t &m) const;
 #else
-	double costp(const NetworkGraph &g, const NetworkState &s,
-			const NetworkGraph::Path &pp, specIndex_t beginp, specIndex_t endp) const;
-	double costb(const NetworkGraph &g, const NetworkState &s,
-			const NetworkGraph::Path &pb, specIndex_t beginb, specIndex_t endb) const;
+	double costp(const NetworkGraph &g, const NetworkState<numSlots> &s,
+			const NetworkGraph::Path &pp, fiberIndex_t fiber, specIndex_t beginp, specIndex_t endp) const;
+	double costb(const NetworkGraph &g, const NetworkState<numSlots> &s,
+			const NetworkGraph::Path &pb, const typename NetworkState<numSlots>::free_blocks_t &freeb,
+			fiberIndex_t fiber, specIndex_t beginb, specIndex_t endb) const;
 #endif
 	double c_cut, c_algn, c_fsb;
+	/// Score the backups on the network with the primary provisioned.
+	bool lookahead;
+	typename NetworkState<numSlots>::ProtectionRows protection;
+	typename NetworkState<numSlots>::ScratchOverlay overlay;
 };
 
 #endif /* KSQHYBRIDCOST2PROVISIONING_H_ */
@@ -21,15 +21,18 @@
  */
 
 #include "KsqHybridCostProvisioning.h"
+#include "../PhaseTimer.h"
 #include "ProvisioningSchemeFactory.h"
 
 #define DEFAULT_WEIGHT 1.0
 
 /// by construction, this registers the class in the ProvisioningSchemeFactory factory.
 static const ProvisioningSchemeFactory::Registrar<KsqHybridCostProvisioning> _reg("ksqold");
-const char *const KsqHybridCostProvisioning::helpstr=
+template<specIndex_t numSlots>
+const char *const KsqHybridCostProvisioning<numSlots>::helpstr=
 		"The k-squared hybrid heuristic (same cost metrics)";
-const ProvisioningScheme::paramDesc_t KsqHybridCostProvisioning::pdesc[]={
+template<specIndex_t numSlots>
+const ProvisioningSchemeBase::paramDesc_t KsqHybridCostProvisioning<numSlots>::pdesc[]={
 		{"k",      "0<k",      XSTR(DEFAULT_K),
 				"Default value for k_pri and k_bkp"},
 		{"k_pri",  "0<k_pri",  "k",
@@ -47,8 +50,9 @@ const ProvisioningScheme::paramDesc_t KsqHybridCostProvisioning::pdesc[]={
 		{0,0,0,0}
 };
 
-KsqHybridCostProvisioning::KsqHybridCostProvisioning(
-		const ProvisioningScheme::ParameterSet &p
+template<specIndex_t numSlots>
+KsqHybridCostProvisioning<numSlots>::KsqHybridCostProvisioning(
+		const ProvisioningSchemeBase::ParameterSet &p
 ):
 		k_pri(DEFAULT_K),
 		k_bkp(DEFAULT_K),
@@ -60,7 +64,8 @@ KsqHybridCostProvisioning::KsqHybridCostProvisioning(
 #endif
 		c_cut(DEFAULT_WEIGHT),
 		c_algn(DEFAULT_WEIGHT),
-		c_fsb(DEFAULT_WEIGHT)
+		c_fsb(DEFAULT_WEIGHT),
+		protection()
 {
 	auto it=p.find("k");
 	if(it!=p.end())	k_pri=k_bkp=lrint(it->second);
@@ -89,7 +94,8 @@ KsqHybridCostProvisioning::KsqHybridCostProvisioning(
 #endif
 }
 
-KsqHybridCostProvisioning::~KsqHybridCostProvisioning() {
+template<specIndex_t numSlots>
+KsqHybridCostProvisioning<numSlots>::~KsqHybridCostProvisioning() {
 #ifdef TEST_METRICS
 	std::cerr<<"Primary: "
 			<< mpsum.m_sep/n <<"; "<< mpsum.m_fsb/n <<"; "
@@ -100,8 +106,9 @@ KsqHybridCostProvisioning::~KsqHybridCostProvisioning() {
 #endif
 }
 
-Provisioning KsqHybridCostProvisioning::operator ()(
-		const NetworkGraph& g, const NetworkState& s, const NetworkGraph::DijkstraData &data,
+template<specIndex_t numSlots>
+Provisioning KsqHybridCostProvisioning<numSlots>::operator ()(
+		const NetworkGraph& g, const NetworkState<numSlots>& s, const NetworkGraph::DijkstraData &data,
 		const Request& r) {
 #ifdef TEST_METRICS
 	metricvals_t mp={0}, mb={0}, mpopt={0}, mbopt={0};
@@ -113,86 +120,101 @@ Provisioning KsqHybridCostProvisioning::operator ()(
 
 	NetworkGraph::YenKShortestSearch y(g,r.source,r.dest,data);
 	const std::vector<NetworkGraph::Path> priPaths=y.getPaths(k_pri);
-	for(auto const &pp:priPaths) {
+	const NetworkGraph::PathTrie priTrie=y.getTrie(k_pri);
+	typename NetworkState<numSlots>::TrieAvailability priAvail(s,priTrie);
+	for(size_t pi=0; pi<priPaths.size(); ++pi) {
+		//the searches within are charged to their own phases
+		PHASE_SCOPE(COST);
+		const NetworkGraph::Path &pp=priPaths[pi];
 		distance_t lenp=0;
 		for(auto const &e:pp) lenp+=data.weights[e.idx];
 		const modulation_t modp=calcModulation(lenp);
 		const specIndex_t widthp=calcNumSlots(r.bandwidth,modp);
-		const NetworkState::spectrum_bits specp=s.priAvailability(pp);
-
 		double coptp=std::numeric_limits<double>::infinity();
-		specIndex_t usedp=0;
-		specIndex_t ip=NUM_SLOTS;
-		for(specIndex_t i=0; i<widthp-1; ++i)
-			if(specp[i]) ++usedp;
-		for(specIndex_t i=0; i<=NUM_SLOTS-widthp; ++i) {
-			if(specp[i+widthp-1]) ++usedp;
-			if(!usedp) {
-				double c;
-				if(mode&1) {
+		specIndex_t ip=numSlots;
+		fiberIndex_t fp=0;
+		for(fiberIndex_t f=0; f<s.getNumFibers(); ++f) {
+			const typename NetworkState<numSlots>::spectrum_bits specp=priAvail.priAvailability(pi,f);
+			specIndex_t usedp=0;
+			for(specIndex_t i=0; i<widthp-1; ++i)
+				if(specp[i]) ++usedp;
+			for(specIndex_t i=0; i<=numSlots-widthp; ++i) {
+				if(specp[i+widthp-1]) ++usedp;
+				if(!usedp) {
+					double c;
+					if(mode&1) {
 #ifdef TEST_METRICS
-					c=costp(g,s,pp,i,i+widthp,mp);
+						c=costp(g,s,pp,f,i,i+widthp,mp);
 #else
-					c=costp(g,s,pp,i,i+widthp);
+						c=costp(g,s,pp,f,i,i+widthp);
 #endif
-				} else {
-					c=i*pp.size();
-				}
-				if(c<coptp) {
-					ip=i;
-					coptp=c;
+					} else {
+						c=i*pp.size();
+					}
+					if(c<coptp) {
+						ip=i;
+						fp=f;
+						coptp=c;
+					}
 				}
+				if(specp[i]) --usedp;
 			}
-			if(specp[i]) --usedp;
 		}
-		if(ip==NUM_SLOTS || coptp>copt) continue;
+		if(ip==numSlots || coptp>copt) continue;
 
 		y.reset();
 		for(auto const &e:pp) data.weights[e.idx]=std::numeric_limits<distance_t>::max();
 		const std::vector<NetworkGraph::Path> &bkpPaths=y.getPaths(k_bkp);
 		for(auto const &e:pp) data.weights[e.idx]=g.link_lengths[e.idx];
+		protection.setPrimary(s,pp);
 
 		for(auto const &pb:bkpPaths) {
 			distance_t lenb=0;
 			for(auto const &e:pb) lenb+=data.weights[e.idx];
 			const modulation_t modb=calcModulation(lenb);
 			const specIndex_t widthb=calcNumSlots(r.bandwidth,modb);
-			const NetworkState::spectrum_bits specb=s.bkpAvailability(pp,pb);
+			for(fiberIndex_t f=0; f<s.getNumFibers(); ++f) {
+				const typename NetworkState<numSlots>::spectrum_bits specb=protection.bkpAvailability(pb,f);
+				typename NetworkState<numSlots>::free_blocks_t freeb;
+				if(mode&2) freeb=s.freeBlockTable(pb,f);
 
-			specIndex_t usedb=0;
-			for(specIndex_t ib=0; ib<widthb-1; ++ib)
-				if(specb[ib]) ++usedb;
-			for(specIndex_t ib=0; ib<=NUM_SLOTS-widthb; ++ib) {
-				if(specb[ib+widthb-1]) ++usedb;
-				if(!usedb) {
-					double c;
-					if(mode&2) {
+				specIndex_t usedb=0;
+				for(specIndex_t ib=0; ib<widthb-1; ++ib)
+					if(specb[ib]) ++usedb;
+				for(specIndex_t ib=0; ib<=numSlots-widthb; ++ib) {
+					if(specb[ib+widthb-1]) ++usedb;
+					if(!usedb) {
+						double c;
+						if(mode&2) {
 #ifdef TEST_METRICS
-						c=coptp+costb(g,s,pb,ib,ib+widthb,mb);
+							c=coptp+costb(g,s,pb,freeb,f,ib,ib+widthb,mb);
 #else
-						c=coptp+costb(g,s,pb,ib,ib+widthb);
+							c=coptp+costb(g,s,pb,freeb,f,ib,ib+widthb);
 #endif
-					} else {
-						c=coptp+(NUM_SLOTS-ib-widthb)*pb.size();
-					}
-					if(c<copt) {
-						result.state=Provisioning::SUCCESS;
-						result.priPath=pp;
-						result.priSpecBegin=ip;
-						result.priSpecEnd=ip+widthp;
-						result.priMod=modp;
-						result.bkpPath=pb;
-						result.bkpSpecBegin=ib;
-						result.bkpSpecEnd=ib+widthb;
-						result.bkpMod=modb;
-						copt=c;
+						} else {
+							c=coptp+(numSlots-ib-widthb)*pb.size();
+						}
+						if(c<copt) {
+							result.state=Provisioning::SUCCESS;
+							result.priPath=pp;
+							result.priFiber=fp;
+							result.priSpecBegin=ip;
+							result.priSpecEnd=ip+widthp;
+							result.priMod=modp;
+							result.bkpPath=pb;
+							result.bkpFiber=f;
+							result.bkpSpecBegin=ib;
+							result.bkpSpecEnd=ib+widthb;
+							result.bkpMod=modb;
+							copt=c;
 #ifdef TEST_METRICS
-						mpopt=mp;
-						mbopt=mb;
+							mpopt=mp;
+							mbopt=mb;
 #endif
+						}
 					}
+					if(specb[ib]) --usedb;
 				}
-				if(specb[ib]) --usedb;
 			}
 		}
 	}
@@ -212,18 +234,20 @@ Provisioning KsqHybridCostProvisioning::operator ()(
 	return result;
 }
 
-std::ostream& KsqHybridCostProvisioning::print(std::ostream& o) const {
-	return printFormatted(o,helpstr,pdesc);
+template<specIndex_t numSlots>
+std::ostream& KsqHybridCostProvisioning<numSlots>::print(std::ostream& o) const {
+	return this->printFormatted(o,helpstr,pdesc);
 }
 
 #ifdef TEST_METRICS
 
-inline double KsqHybridCostProvisioning::costp(const NetworkGraph& g,
-		const NetworkState& s, const NetworkGraph::Path& pp, specIndex_t beginp,
+template<specIndex_t numSlots>
+inline double KsqHybridCostProvisioning<numSlots>::costp(const NetworkGraph& g,
+		const NetworkState<numSlots>& s, const NetworkGraph::Path& pp, fiberIndex_t fiber, specIndex_t beginp,
 		specIndex_t endp, metricvals_t &m) const {
 	m.m_fsb=pp.size()*(endp-beginp);
-	m.m_cut=s.calcCuts(g,pp,beginp,endp);
-	m.m_algn=s.calcMisalignments(g,pp,beginp,endp);
+	m.m_cut=s.calcCuts(g,pp,beginp,endp,fiber);
+	m.m_algn=s.calcMisalignments(g,pp,beginp,endp,fiber);
 	m.m_sep=beginp*pp.size();
 	return    c_fsb  * m.m_fsb
 			+ c_cut  * m.m_cut
@@ -231,49 +255,57 @@ inline double KsqHybridCostProvisioning::costp(const NetworkGraph& g,
 			+          m.m_sep;
 	/*
 	return	 c_fsb *(  pp.size()*(endp-beginp))
-			+c_cut *(         s.calcCuts(g,pp,beginp,endp))
-			+c_algn*(s.calcMisalignments(g,pp,beginp,endp))
+			+c_cut *(         s.calcCuts(g,pp,beginp,endp,fiber))
+			+c_algn*(s.calcMisalignments(g,pp,beginp,endp,fiber))
 			+       beginp*pp.size();
 	*/
 }
 
-inline double KsqHybridCostProvisioning::costb(const NetworkGraph& g,
-		const NetworkState& s, const NetworkGraph::Path& pb, specIndex_t beginb,
+template<specIndex_t numSlots>
+inline double KsqHybridCostProvisioning<numSlots>::costb(const NetworkGraph& g,
+		const NetworkState<numSlots>& s, const NetworkGraph::Path& pb,
+		const typename NetworkState<numSlots>::free_blocks_t &freeb, fiberIndex_t fiber, specIndex_t beginb,
 		specIndex_t endb, metricvals_t &m) const {
-	m.m_fsb=s.countFreeBlocks(pb,beginb,endb);
-	m.m_cut=s.calcCuts(g,pb,beginb,endb);
-	m.m_algn=s.calcMisalignments(g,pb,beginb,endb);
-	m.m_sep=(NUM_SLOTS-endb)*pb.size();
+	m.m_fsb=freeb[endb]-freeb[beginb];
+	m.m_cut=s.calcCuts(g,pb,beginb,endb,fiber);
+	m.m_algn=s.calcMisalignments(g,pb,beginb,endb,fiber);
+	m.m_sep=(numSlots-endb)*pb.size();
 	return    c_fsb  * m.m_fsb
 			+ c_cut  * m.m_cut
 			+ c_algn * m.m_algn
 			+          m.m_sep;
 	/*
-	return	 c_fsb *(    s.countFreeBlocks(pb,beginb,endb))
-			+c_cut *(         s.calcCuts(g,pb,beginb,endb))
-			+c_algn*(s.calcMisalignments(g,pb,beginb,endb))
-			+       (NUM_SLOTS-endb)*pb.size();
+	return	 c_fsb *(    s.countFreeBlocks(pb,beginb,endb,fiber))
+			+c_cut *(         s.calcCuts(g,pb,beginb,endb,fiber))
+			+c_algn*(s.calcMisalignments(g,pb,beginb,endb,fiber))
+			+       (numSlots-endb)*pb.size();
 	*/
 }
 
 #else
 
-inline double KsqHybridCostProvisioning::costp(const NetworkGraph& g,
-		const NetworkState& s, const NetworkGraph::Path& pp, specIndex_t beginp,
+template<specIndex_t numSlots>
+inline double KsqHybridCostProvisioning<numSlots>::costp(const NetworkGraph& g,
+		const NetworkState<numSlots>& s, const NetworkGraph::Path& pp, fiberIndex_t fiber, specIndex_t beginp,
 		specIndex_t endp) const {
 	return	 c_fsb *(  pp.size()*(endp-beginp))
-			+c_cut *(         s.calcCuts(g,pp,beginp,endp))
-			+c_algn*(s.calcMisalignments(g,pp,beginp,endp))
+			+c_cut *(         s.calcCuts(g,pp,beginp,endp,fiber))
+			+c_algn*(s.calcMisalignments(g,pp,beginp,endp,fiber))
 			+       beginp*pp.size();
 }
 
-inline double KsqHybridCostProvisioning::costb(const NetworkGraph& g,
-		const NetworkState& s, const NetworkGraph::Path& pb, specIndex_t beginb,
+template<specIndex_t numSlots>
+inline double KsqHybridCostProvisioning<numSlots>::costb(const NetworkGraph& g,
+		const NetworkState<numSlots>& s, const NetworkGraph::Path& pb,
+		const typename NetworkState<numSlots>::free_blocks_t &freeb, fiberIndex_t fiber, specIndex_t beginb,
 		specIndex_t endb) const {
-	return	 c_fsb *(    s.countFreeBlocks(pb,beginb,endb))
-			+c_cut *(         s.calcCuts(g,pb,beginb,endb))
-			+c_algn*(s.calcMisalignments(g,pb,beginb,endb))
-			+       (NUM_SLOTS-endb)*pb.size();
+	return	 c_fsb *(    freeb[endb]-freeb[beginb])
+			+c_cut *(         s.calcCuts(g,pb,beginb,endb,fiber))
+			+c_algn*(s.calcMisalignments(g,pb,beginb,endb,fiber))
+			+       (numSlots-endb)*pb.size();
 }
 
 #endif
+
+#define INSTANTIATE_KSQHYBRIDCOSTPROVISIONING(n) template class KsqHybridCostProvisioning<n>;
+FOR_EACH_NUM_SLOTS(INSTANTIATE_KSQHYBRIDCOSTPROVISIONING)
@@ -35,16 +35,17 @@
 /**
  * \brief Implementation of the $k^2$ shortest path heuristic with hybrid cost metric.
  */
-class KsqHybridCostProvisioning: public ProvisioningScheme {
+template<specIndex_t numSlots>
+class KsqHybridCostProvisioning: public ProvisioningScheme<numSlots> {
 public:
-	KsqHybridCostProvisioning(const ParameterSet &p);
+	KsqHybridCostProvisioning(const ProvisioningSchemeBase::ParameterSet &p);
 	virtual ~KsqHybridCostProvisioning();
-	virtual Provisioning operator()(const NetworkGraph &g, const NetworkState &s, const NetworkGraph::DijkstraData &data, const Request &r);
+	virtual Provisioning operator()(const NetworkGraph &g, const NetworkState<numSlots> &s, const NetworkGraph::DijkstraData &data, const Request &r);
 protected:
 	virtual std::ostream& print(std::ostream &o) const;
 private:
 	static const char *const helpstr;
-	static const paramDesc_t pdesc[];
+	static const ProvisioningSchemeBase::paramDesc_t pdesc[];
 	unsigned int k_pri; ///< Number of paths to consider for the primary
 	unsigned int k_bkp; ///< Number of paths to consider for backup, per primary
 	unsigned int mode;
@@ -54,17 +55,20 @@ private:
 	} metricvals_t;
 	int64_t n;
 	metricvals_t mpsum, mbsum;
-	double costp(const NetworkGraph &g, const NetworkState &s,
-			const NetworkGraph::Path &pp, specIndex_t beginp, specIndex_t endp, metricvals_t &m) const;
-	double costb(const NetworkGraph &g, const NetworkState &s,
-			const NetworkGraph::Path &pb, specIndex_t beginb, specIndex_t endb, metricvals_t &m) const;
+	double costp(const NetworkGraph &g, const NetworkState<numSlots> &s,
+			const NetworkGraph::Path &pp, fiberIndex_t fiber, specIndex_t beginp, specIndex_t endp, metricvals_t &m) const;
+	double costb(const NetworkGraph &g, const NetworkState<numSlots> &s,
+			const NetworkGraph::Path &pb, const typename NetworkState<numSlots>::free_blocks_t &freeb,
+			fiberIndex_t fiber, specIndex_t beginb, specIndex_t endb, metricvals_t &m) const;
 #else
-	double costp(const NetworkGraph &g, const NetworkState &s,
-			const NetworkGraph::Path &pp, specIndex_t beginp, specIndex_t endp) const;
-	double costb(const NetworkGraph &g, const NetworkState &s,
-			const NetworkGraph::Path &pb, specIndex_t beginb, specIndex_t endb) const;
+	double costp(const NetworkGraph &g, const NetworkState<numSlots> &s,
+			const NetworkGraph::Path &pp, fiberIndex_t fiber, specIndex_t beginp, specIndex_t endp) const;
+	double costb(const NetworkGraph &g, const NetworkState<numSlots> &s,
+			const NetworkGraph::Path &pb, const typename NetworkState<numSlots>::free_blocks_t &freeb,
+			fiberIndex_t fiber, specIndex_t beginb, specIndex_t endb) const;
 #endif
 	double c_cut, c_algn, c_fsb;
+	typename NetworkState<numSlots>::ProtectionRows protection;
 };
 
 #endif /* KSQHYBRIDCOSTPROVISIONING_H_ */
@@ -0,0 +1,84 @@
+/**
+ * @file MemoProvisioning.cpp
+ *
+ */
+
+/*
+ * This file is part of eonsim.
+ *
+ * eonsim is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * eonsim is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with eonsim.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#include "MemoProvisioning.h"
+
+#include <algorithm>
+
+#include "../globaldef.h"
+
+template<specIndex_t numSlots>
+MemoProvisioning<numSlots>::MemoProvisioning(std::unique_ptr<ProvisioningScheme<numSlots> > &&scheme):
+		scheme(std::move(scheme)),
+		memo(),
+		reads()
+{}
+
+template<specIndex_t numSlots>
+MemoProvisioning<numSlots>::~MemoProvisioning() {
+}
+
+template<specIndex_t numSlots>
+Provisioning MemoProvisioning<numSlots>::operator ()(const NetworkGraph& g,
+		const NetworkState<numSlots>& s, const NetworkGraph::DijkstraData &data, const Request& r) {
+	const uint64_t key=((uint64_t)r.source<<48) | ((uint64_t)r.dest<<32) | r.bandwidth;
+	Entry &e=memo[key];
+	if(!e.links.empty() && isCurrent(s,e)) return e.result;
+
+	reads.links.clear();
+	reads.nodes.clear();
+	s.trackReads(&reads);
+	e.result=(*scheme)(g,s,data,r);
+	s.trackReads(0);
+
+	std::sort(reads.links.begin(),reads.links.end());
+	reads.links.erase(std::unique(reads.links.begin(),reads.links.end()),reads.links.end());
+	std::sort(reads.nodes.begin(),reads.nodes.end());
+	reads.nodes.erase(std::unique(reads.nodes.begin(),reads.nodes.end()),reads.nodes.end());
+	e.links.clear();
+	for(linkIndex_t l:reads.links)
+		e.links.push_back(std::make_pair(l,s.getLinkVersion(l)));
+	e.nodes.clear();
+	for(nodeIndex_t n:reads.nodes)
+		e.nodes.push_back(std::make_pair(n,s.getNodeVersion(n)));
+	return e.result;
+}
+
+/**
+ * Check if none of the links and nodes that an entry depends on has changed.
+ */
+template<specIndex_t numSlots>
+bool MemoProvisioning<numSlots>::isCurrent(const NetworkState<numSlots>& s, const Entry& e) const {
+	for(auto const &l:e.links)
+		if(s.getLinkVersion(l.first)!=l.second) return false;
+	for(auto const &n:e.nodes)
+		if(s.getNodeVersion(n.first)!=n.second) return false;
+	return true;
+}
+
+template<specIndex_t numSlots>
+std::ostream& MemoProvisioning<numSlots>::print(std::ostream& o) const {
+	return o<<*scheme;
+}
+
+#define INSTANTIATE_MEMOPROVISIONING(n) template class MemoProvisioning<n>;
+FOR_EACH_NUM_SLOTS(INSTANTIATE_MEMOPROVISIONING)
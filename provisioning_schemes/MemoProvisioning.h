@@ -0,0 +1,67 @@
+/**
+ * @file MemoProvisioning.h
+ *
+ */
+
+/*
+ * This file is part of eonsim.
+ *
+ * eonsim is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * eonsim is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with eonsim.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#ifndef MEMOPROVISIONING_H_
+#define MEMOPROVISIONING_H_
+
+#include <cstdint>
+#include <iostream>
+#include <memory>
+#include <unordered_map>
+#include <utility>
+#include <vector>
+
+#include "ProvisioningScheme.h"
+
+/**
+ * \brief Remembers the results of another heuristic for recurring requests.
+ *
+ * The results are stored per source, destination and bandwidth together
+ * with the versions of all links and nodes that the heuristic has read
+ * from the NetworkState. A request is only answered from the table if none
+ * of them has changed since, so the results are the same as without the
+ * table. This is enabled with the global parameter "memo".
+ */
+template<specIndex_t numSlots>
+class MemoProvisioning: public ProvisioningScheme<numSlots> {
+public:
+	MemoProvisioning(std::unique_ptr<ProvisioningScheme<numSlots> > &&scheme);
+	virtual ~MemoProvisioning();
+	virtual Provisioning operator()(const NetworkGraph &g, const NetworkState<numSlots> &s, const NetworkGraph::DijkstraData &data, const Request &r);
+protected:
+	virtual std::ostream& print(std::ostream &o) const;
+private:
+	/**
+	 * \brief A remembered result and the state it was computed from.
+	 */
+	struct Entry {
+		Provisioning result;
+		std::vector<std::pair<linkIndex_t, uint64_t> > links;
+		std::vector<std::pair<nodeIndex_t, uint64_t> > nodes;
+	};
+	std::unique_ptr<ProvisioningScheme<numSlots> > scheme;
+	std::unordered_map<uint64_t, Entry> memo;
+	typename NetworkState<numSlots>::ReadSet reads;
+	bool isCurrent(const NetworkState<numSlots> &s, const Entry &e) const;
+};
+
+#endif /* MEMOPROVISIONING_H_ */
@@ -24,14 +24,14 @@
 
 #include <iomanip>
 
-ProvisioningScheme::~ProvisioningScheme() {
+ProvisioningSchemeBase::~ProvisioningSchemeBase() {
 }
 
-std::ostream& operator<<(std::ostream& o, ProvisioningScheme const& s) {
+std::ostream& operator<<(std::ostream& o, ProvisioningSchemeBase const& s) {
 	return s.print(o);
 }
 
-std::ostream& ProvisioningScheme::printFormatted(std::ostream& o,
+std::ostream& ProvisioningSchemeBase::printFormatted(std::ostream& o,
 		const char* const helpstr, const paramDesc_t* const params) const {
 	o<<helpstr<<". Supported parameters:"<<std::endl;
 	o.fill(' ');
@@ -24,25 +24,21 @@
 #define PROVISIONINGSCHEME_H_
 
 #include <iostream>
+#include <map>
+#include <string>
 
 #include "../NetworkGraph.h"
 #include "../NetworkState.h"
 #include "../SimulationMsgs.h"
 
 /**
- * \brief Interface of a provisioning heuristic.
- *
- * Classes that implement a heuristic should inherit from this class and define
- * a ProvisioningSchemeFactory::Registrar object to register with the
- * ProvisioningSchemeFactory. See one of the existing heuristics to see how this
- * is done.
+ * \brief Parts of the heuristic interface that do not depend on the number of slots.
  */
-class ProvisioningScheme {
+class ProvisioningSchemeBase {
 public:
 	typedef std::map<std::string,double> ParameterSet;
-	virtual ~ProvisioningScheme();
-	virtual Provisioning operator()(const NetworkGraph &g, const NetworkState &s, const NetworkGraph::DijkstraData &data, const Request &r) =0;
-	friend std::ostream& operator<<(std::ostream& o, ProvisioningScheme const& s);
+	virtual ~ProvisioningSchemeBase();
+	friend std::ostream& operator<<(std::ostream& o, ProvisioningSchemeBase const& s);
 protected:
 	/**
 	 * \brief Description of a parameter that a heuristic accepts; used for printing usage information.
@@ -58,4 +54,19 @@ protected:
 			const char *const helpstr, const paramDesc_t *const params) const;
 };
 
+/**
+ * \brief Interface of a provisioning heuristic.
+ *
+ * Classes that implement a heuristic should be class templates on the number
+ * of slots, inherit from this class and define a
+ * ProvisioningSchemeFactory::Registrar object to register with the
+ * ProvisioningSchemeFactory. See one of the existing heuristics to see how this
+ * is done.
+ */
+template<specIndex_t numSlots>
+class ProvisioningScheme: public ProvisioningSchemeBase {
+public:
+	virtual Provisioning operator()(const NetworkGraph &g, const NetworkState<numSlots> &s, const NetworkGraph::DijkstraData &data, const Request &r) =0;
+};
+
 #endif /* PROVISIONINGSCHEME_H_ */
@@ -26,13 +26,14 @@ const ProvisioningSchemeFactory& ProvisioningSchemeFactory::getInstance() {
 	return getMutableInstance();
 }
 
-std::unique_ptr<ProvisioningScheme> ProvisioningSchemeFactory::create(
+ProvisioningSchemeBase *ProvisioningSchemeFactory::create(
 		const std::string &name,
-		const ProvisioningScheme::ParameterSet& params) const {
+		const ProvisioningSchemeBase::ParameterSet& params,
+		specIndex_t numSlots) const {
 	auto it=factoryFunctionRegistry.find(name);
 
 	if(it==factoryFunctionRegistry.end()) return 0;
-	else return it->second(params);
+	else return it->second(params,numSlots);
 }
 
 ProvisioningSchemeFactory::ProvisioningSchemeFactory() {
@@ -49,7 +50,7 @@ ProvisioningSchemeFactory& ProvisioningSchemeFactory::getMutableInstance() {
 
 std::ostream& ProvisioningSchemeFactory::printHelp(std::ostream& o) const {
 	for(const auto &p:factoryFunctionRegistry) {
-		auto ps=p.second(ProvisioningScheme::ParameterSet());
+		std::unique_ptr<ProvisioningSchemeBase> ps(p.second(ProvisioningSchemeBase::ParameterSet(),DEFAULT_NUM_SLOTS));
 		o<<p.first<<": "<<*ps<<std::endl;
 	}
 	return o;
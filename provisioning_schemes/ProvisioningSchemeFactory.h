@@ -27,7 +27,9 @@
 #include <map>
 #include <string>
 #include <iostream>
+#include <memory>
 
+#include "../globaldef.h"
 #include "ProvisioningScheme.h"
 
 /**
@@ -37,24 +39,42 @@ class ProvisioningSchemeFactory {
 public:
 	~ProvisioningSchemeFactory();
 	static const ProvisioningSchemeFactory &getInstance();
-	std::unique_ptr<ProvisioningScheme> create(const std::string &name, const ProvisioningScheme::ParameterSet &params) const;
+	/**
+	 * Create a heuristic by name, for a NetworkState with the given number of slots.
+	 * @return The new heuristic, or an empty pointer if the name is unknown.
+	 */
+	template<specIndex_t numSlots>
+	std::unique_ptr<ProvisioningScheme<numSlots> > create(const std::string &name, const ProvisioningSchemeBase::ParameterSet &params) const {
+		return std::unique_ptr<ProvisioningScheme<numSlots> >(
+				static_cast<ProvisioningScheme<numSlots>*>(create(name,params,numSlots)));
+	}
 	std::ostream &printHelp(std::ostream &o) const;
 private:
 	ProvisioningSchemeFactory();
 	ProvisioningSchemeFactory(const ProvisioningSchemeFactory &);
 	static ProvisioningSchemeFactory &getMutableInstance();
-	std::map<std::string, std::function<std::unique_ptr<ProvisioningScheme>(const ProvisioningScheme::ParameterSet &)>> factoryFunctionRegistry;
+	ProvisioningSchemeBase *create(const std::string &name, const ProvisioningSchemeBase::ParameterSet &params, specIndex_t numSlots) const;
+	typedef ProvisioningSchemeBase *(*factoryFunction_t)(const ProvisioningSchemeBase::ParameterSet &, specIndex_t);
+	std::map<std::string, factoryFunction_t> factoryFunctionRegistry;
 public:
 	/**
 	 * \brief A helper object that, when constructed, registers the template parameter class with the ProvisioningSchemeFactory.
+	 *
+	 * The registered class template is instantiated for every slot count in FOR_EACH_NUM_SLOTS.
 	 */
-	template<class T> class Registrar {
+	template<template<specIndex_t> class T> class Registrar {
 	public:
 		Registrar(const std::string &name) {
-			ProvisioningSchemeFactory::getMutableInstance().factoryFunctionRegistry[name]=
-					[](const ProvisioningScheme::ParameterSet &p) -> std::unique_ptr<ProvisioningScheme>{
-				return std::unique_ptr<ProvisioningScheme>(new T(p));
-			};
+			ProvisioningSchemeFactory::getMutableInstance().factoryFunctionRegistry[name]=&construct;
+		}
+	private:
+		static ProvisioningSchemeBase *construct(const ProvisioningSchemeBase::ParameterSet &p, specIndex_t numSlots) {
+			switch(numSlots) {
+#define CONSTRUCT_FOR_NUM_SLOTS(n) case n: return new T<n>(p);
+			FOR_EACH_NUM_SLOTS(CONSTRUCT_FOR_NUM_SLOTS)
+#undef CONSTRUCT_FOR_NUM_SLOTS
+			default: return 0;
+			}
 		}
 	};
 };
@@ -32,9 +32,11 @@
 
 /// by construction, this registers the class in the ProvisioningSchemeFactory factory.
 static const ProvisioningSchemeFactory::Registrar<Shao2012FFProvisioning> _reg("ff");
-const char *const Shao2012FFProvisioning::helpstr=
+template<specIndex_t numSlots>
+const char *const Shao2012FFProvisioning<numSlots>::helpstr=
 		"A simple first-fit heuristic";
-const ProvisioningScheme::paramDesc_t Shao2012FFProvisioning::pdesc[]={
+template<specIndex_t numSlots>
+const ProvisioningSchemeBase::paramDesc_t Shao2012FFProvisioning<numSlots>::pdesc[]={
 		{"k",      "0<k",      XSTR(DEFAULT_K),
 				"Default value for k_pri and k_bkp"},
 		{"k_pri",  "0<k_pri",  "k",
@@ -44,9 +46,11 @@ const ProvisioningScheme::paramDesc_t Shao2012FFProvisioning::pdesc[]={
 		{0,0,0,0}
 };
 
-Shao2012FFProvisioning::Shao2012FFProvisioning(const ProvisioningScheme::ParameterSet &p):
+template<specIndex_t numSlots>
+Shao2012FFProvisioning<numSlots>::Shao2012FFProvisioning(const ProvisioningSchemeBase::ParameterSet &p):
 	k_pri(DEFAULT_K),
-	k_bkp(DEFAULT_K)
+	k_bkp(DEFAULT_K),
+	protection()
 {
 	auto it=p.find("k");
 	if(it!=p.end())
@@ -59,11 +63,13 @@ Shao2012FFProvisioning::Shao2012FFProvisioning(const ProvisioningScheme::Paramet
 		k_bkp=lrint(it->second);
 }
 
-Shao2012FFProvisioning::~Shao2012FFProvisioning() {
+template<specIndex_t numSlots>
+Shao2012FFProvisioning<numSlots>::~Shao2012FFProvisioning() {
 }
 
-Provisioning Shao2012FFProvisioning::operator ()(const NetworkGraph& g,
-		const NetworkState& s, const NetworkGraph::DijkstraData &data, const Request& r) {
+template<specIndex_t numSlots>
+Provisioning Shao2012FFProvisioning<numSlots>::operator ()(const NetworkGraph& g,
+		const NetworkState<numSlots>& s, const NetworkGraph::DijkstraData &data, const Request& r) {
 	Provisioning result;
 	result.bandwidth=r.bandwidth;
 	result.priSpecEnd=0;
@@ -72,11 +78,13 @@ Provisioning Shao2012FFProvisioning::operator ()(const NetworkGraph& g,
 	NetworkGraph::YenKShortestSearch y(g,r.source,r.dest,data);
 	{
 		const std::vector<NetworkGraph::Path> &priPaths=y.getPaths(k_pri);
+		typename NetworkState<numSlots>::TrieAvailability priAvail(s,y.getTrie(k_pri));
 		if(priPaths.empty()) {
 			result.state=Provisioning::BLOCK_PRI_NOPATH;
 			return result;
 		}
-		for(auto const &p:priPaths) {
+		for(size_t pi=0; pi<priPaths.size(); ++pi) {
+			const NetworkGraph::Path &p=priPaths[pi];
 			distance_t len=0;
 			for(auto const &e:p) len+=data.weights[e.idx];
 
@@ -87,18 +95,9 @@ Provisioning Shao2012FFProvisioning::operator ()(const NetworkGraph& g,
 			}
 			specIndex_t neededSpec=calcNumSlots(r.bandwidth,result.priMod);
 
-			const NetworkState::spectrum_bits spec=s.priAvailability(p);
-
-			specIndex_t count=0;
-			for(specIndex_t i=0; i<NUM_SLOTS; ++i) {
-				if(spec[i]) count=0;
-				else if(++count==neededSpec) {
-					result.priSpecBegin=i-count+1;
-					result.priSpecEnd=i+1;
-					break;
-				}
-			}
-			if(result.priSpecEnd) {
+			//first-fit over all fibers
+			if(priAvail.firstFit(pi,neededSpec,result.priFiber,result.priSpecBegin)) {
+				result.priSpecEnd=result.priSpecBegin+neededSpec;
 				result.priPath=p;
 				break;
 			}
@@ -115,6 +114,7 @@ Provisioning Shao2012FFProvisioning::operator ()(const NetworkGraph& g,
 		for(auto const &e:result.priPath) data.weights[e.idx]=std::numeric_limits<distance_t>::max();
 		const std::vector<NetworkGraph::Path> &bkpPaths=y.getPaths(k_bkp);
 		for(auto const &e:result.priPath) data.weights[e.idx]=g.link_lengths[e.idx];
+		protection.setPrimary(s,result.priPath);
 		if(bkpPaths.empty()) {
 			result.state=Provisioning::BLOCK_SEC_NOPATH;
 			return result;
@@ -130,18 +130,9 @@ Provisioning Shao2012FFProvisioning::operator ()(const NetworkGraph& g,
 			}
 			specIndex_t neededSpec=calcNumSlots(r.bandwidth,result.bkpMod);
 
-			const NetworkState::spectrum_bits spec=s.bkpAvailability(result.priPath,p);
-
-			specIndex_t count=0;
-			for(specIndex_t i=0; i<NUM_SLOTS; ++i) {
-				if(spec[i]) count=0;
-				else if(++count==neededSpec) {
-					result.bkpSpecBegin=i-count+1;
-					result.bkpSpecEnd=i+1;
-					break;
-				}
-			}
-			if(result.bkpSpecEnd) {
+			//first-fit over all fibers
+			if(protection.firstFit(p,neededSpec,result.bkpFiber,result.bkpSpecBegin)) {
+				result.bkpSpecEnd=result.bkpSpecBegin+neededSpec;
 				result.bkpPath=p;
 				break;
 			}
@@ -156,10 +147,15 @@ Provisioning Shao2012FFProvisioning::operator ()(const NetworkGraph& g,
 	return result;
 }
 
-std::ostream& Shao2012FFProvisioning::print(std::ostream& o) const {
-	return printFormatted(o,helpstr,pdesc);
+template<specIndex_t numSlots>
+std::ostream& Shao2012FFProvisioning<numSlots>::print(std::ostream& o) const {
+	return this->printFormatted(o,helpstr,pdesc);
 }
 
-ProvisioningScheme* Shao2012FFProvisioning::clone() {
+template<specIndex_t numSlots>
+ProvisioningScheme<numSlots>* Shao2012FFProvisioning<numSlots>::clone() {
 	return new Shao2012FFProvisioning(*this);
 }
+
+#define INSTANTIATE_SHAO2012FFPROVISIONING(n) template class Shao2012FFProvisioning<n>;
+FOR_EACH_NUM_SLOTS(INSTANTIATE_SHAO2012FFPROVISIONING)
@@ -29,18 +29,20 @@
 /**
  * \brief Implementation of the first-fit heuristic.
  */
-class Shao2012FFProvisioning: public ProvisioningScheme {
+template<specIndex_t numSlots>
+class Shao2012FFProvisioning: public ProvisioningScheme<numSlots> {
 public:
-	Shao2012FFProvisioning(const ParameterSet &p);
+	Shao2012FFProvisioning(const ProvisioningSchemeBase::ParameterSet &p);
 	virtual ~Shao2012FFProvisioning();
-	virtual ProvisioningScheme *clone();
-	virtual Provisioning operator()(const NetworkGraph &g, const NetworkState &s, const NetworkGraph::DijkstraData &data, const Request &r);
+	virtual ProvisioningScheme<numSlots> *clone();
+	virtual Provisioning operator()(const NetworkGraph &g, const NetworkState<numSlots> &s, const NetworkGraph::DijkstraData &data, const Request &r);
 protected:
 	virtual std::ostream& print(std::ostream &o) const;
 private:
 	static const char *const helpstr;
-	static const paramDesc_t pdesc[];
+	static const ProvisioningSchemeBase::paramDesc_t pdesc[];
 	unsigned int k_pri, k_bkp;
+	typename NetworkState<numSlots>::ProtectionRows protection;
 };
 
 #endif /* SHAO2012FFPROVISIONING_H_ */
@@ -41,19 +41,23 @@
 
 /// by construction, this registers the class in the ProvisioningSchemeFactory factory.
 static const ProvisioningSchemeFactory::Registrar<ShortestFFLFProvisioning> _reg("fflf");
-const char *const ShortestFFLFProvisioning::helpstr=
+template<specIndex_t numSlots>
+const char *const ShortestFFLFProvisioning<numSlots>::helpstr=
 		"The Shortest-path first-fit/last-fit heuristic";
 
 using namespace boost;
 
-ShortestFFLFProvisioning::ShortestFFLFProvisioning(const ProvisioningScheme::ParameterSet &p) {
+template<specIndex_t numSlots>
+ShortestFFLFProvisioning<numSlots>::ShortestFFLFProvisioning(const ProvisioningSchemeBase::ParameterSet &p) {
 }
 
-ShortestFFLFProvisioning::~ShortestFFLFProvisioning() {
+template<specIndex_t numSlots>
+ShortestFFLFProvisioning<numSlots>::~ShortestFFLFProvisioning() {
 }
 
-Provisioning ShortestFFLFProvisioning::operator ()(const NetworkGraph& g,
-		const NetworkState& s, const NetworkGraph::DijkstraData &data, const Request& r) {
+template<specIndex_t numSlots>
+Provisioning ShortestFFLFProvisioning<numSlots>::operator ()(const NetworkGraph& g,
+		const NetworkState<numSlots>& s, const NetworkGraph::DijkstraData &data, const Request& r) {
 	Provisioning result;
 	result.bandwidth=r.bandwidth;
 
@@ -71,17 +75,15 @@ Provisioning ShortestFFLFProvisioning::operator ()(const NetworkGraph& g,
 	//calculate needed spectrum
 	specIndex_t neededSpec=calcNumSlots(r.bandwidth,result.priMod);
 
-	//get path spectrum
-	NetworkState::spectrum_bits spec=s.priAvailability(result.priPath);
-
-	//first-fit
-	specIndex_t count=0;
+	//first-fit over all fibers
 	result.priSpecEnd=0;
-	for(specIndex_t i=0; i<NUM_SLOTS; ++i) {
-		if(spec[i]) count=0;
-		else if(++count==neededSpec) {
-			result.priSpecBegin=i-count+1;
-			result.priSpecEnd=i+1;
+	for(fiberIndex_t f=0; f<s.getNumFibers(); ++f) {
+		const specIndex_t begin=NetworkState<numSlots>::firstFit(
+				s.priAvailability(result.priPath,f),neededSpec);
+		if(begin<numSlots) {
+			result.priFiber=f;
+			result.priSpecBegin=begin;
+			result.priSpecEnd=begin+neededSpec;
 			break;
 		}
 	}
@@ -106,22 +108,25 @@ Provisioning ShortestFFLFProvisioning::operator ()(const NetworkGraph& g,
 	//calculate needed spectrum
 	neededSpec=calcNumSlots(r.bandwidth,result.bkpMod);
 
-	//get path spectrum
-	spec=s.bkpAvailability(result.priPath,result.bkpPath);
-
-
-	//last-fit
-	count=0;
+	//last-fit on the first fiber that has room
 	//result.bkpSpecBegin=0;
 	result.bkpSpecEnd=0;
-	for(specIndex_t i=NUM_SLOTS-1; ; --i) {
-		if(spec[i]) count=0;
-		else if(++count==neededSpec) {
-			result.bkpSpecBegin=i;
-			result.bkpSpecEnd=i+count;
-			break;
+	for(fiberIndex_t f=0; f<s.getNumFibers() && !result.bkpSpecEnd; ++f) {
+		//get path spectrum
+		const typename NetworkState<numSlots>::spectrum_bits spec=
+				s.bkpAvailability(result.priPath,result.bkpPath,f);
+
+		specIndex_t count=0;
+		for(specIndex_t i=numSlots-1; ; --i) {
+			if(spec[i]) count=0;
+			else if(++count==neededSpec) {
+				result.bkpFiber=f;
+				result.bkpSpecBegin=i;
+				result.bkpSpecEnd=i+count;
+				break;
+			}
+			if(!i) break;
 		}
-		if(!i) break;
 	}
 
 	if(!result.bkpSpecEnd) {
@@ -134,10 +139,15 @@ Provisioning ShortestFFLFProvisioning::operator ()(const NetworkGraph& g,
 	return result;
 }
 
-std::ostream& ShortestFFLFProvisioning::print(std::ostream& o) const {
+template<specIndex_t numSlots>
+std::ostream& ShortestFFLFProvisioning<numSlots>::print(std::ostream& o) const {
 	return o<<helpstr<<" (No parameters)."<<std::endl;
 }
 
-ProvisioningScheme* ShortestFFLFProvisioning::clone() {
+template<specIndex_t numSlots>
+ProvisioningScheme<numSlots>* ShortestFFLFProvisioning<numSlots>::clone() {
 	return new ShortestFFLFProvisioning(*this);
 }
+
+#define INSTANTIATE_SHORTESTFFLFPROVISIONING(n) template class ShortestFFLFProvisioning<n>;
+FOR_EACH_NUM_SLOTS(INSTANTIATE_SHORTESTFFLFPROVISIONING)
@@ -31,12 +31,13 @@ struct Request;
 /**
  * \brief Implementation of a simple heuristic that uses only the shortest paths and assigns spectrum by first-fit/last-fit.
  */
-class ShortestFFLFProvisioning: public ProvisioningScheme {
+template<specIndex_t numSlots>
+class ShortestFFLFProvisioning: public ProvisioningScheme<numSlots> {
 public:
-	ShortestFFLFProvisioning(const ParameterSet &p);
+	ShortestFFLFProvisioning(const ProvisioningSchemeBase::ParameterSet &p);
 	virtual ~ShortestFFLFProvisioning();
-	virtual ProvisioningScheme *clone();
-	virtual Provisioning operator()(const NetworkGraph &g, const NetworkState &s, const NetworkGraph::DijkstraData &data, const Request &r);
+	virtual ProvisioningScheme<numSlots> *clone();
+	virtual Provisioning operator()(const NetworkGraph &g, const NetworkState<numSlots> &s, const NetworkGraph::DijkstraData &data, const Request &r);
 protected:
 	static const char *const helpstr;
 	virtual std::ostream& print(std::ostream &o) const;
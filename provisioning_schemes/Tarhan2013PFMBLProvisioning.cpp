@@ -29,9 +29,11 @@
 
 /// by construction, this registers the class in the ProvisioningSchemeFactory factory.
 static const ProvisioningSchemeFactory::Registrar<Tarhan2013PFMBLProvisioning> _reg("pfmbl");
-const char *const Tarhan2013PFMBLProvisioning::helpstr=
+template<specIndex_t numSlots>
+const char *const Tarhan2013PFMBLProvisioning<numSlots>::helpstr=
 		"The k-squared hybrid heuristic";
-const ProvisioningScheme::paramDesc_t Tarhan2013PFMBLProvisioning::pdesc[]={
+template<specIndex_t numSlots>
+const ProvisioningSchemeBase::paramDesc_t Tarhan2013PFMBLProvisioning<numSlots>::pdesc[]={
 		{"k",      "0<k",      XSTR(DEFAULT_K),
 				"Default value for k_pri and k_bkp"},
 		{"k_pri",  "0<k_pri",  "k",
@@ -43,10 +45,12 @@ const ProvisioningScheme::paramDesc_t Tarhan2013PFMBLProvisioning::pdesc[]={
 		{0,0,0,0}
 };
 
-Tarhan2013PFMBLProvisioning::Tarhan2013PFMBLProvisioning(const ProvisioningScheme::ParameterSet &p):
+template<specIndex_t numSlots>
+Tarhan2013PFMBLProvisioning<numSlots>::Tarhan2013PFMBLProvisioning(const ProvisioningSchemeBase::ParameterSet &p):
 		k_pri(DEFAULT_K),
 		k_bkp(DEFAULT_K),
-		c1(DEFAULT_C1*1000)
+		c1(DEFAULT_C1*1000),
+		protection()
 {
 	auto it=p.find("k");
 	if(it!=p.end())
@@ -63,11 +67,13 @@ Tarhan2013PFMBLProvisioning::Tarhan2013PFMBLProvisioning(const ProvisioningSchem
 
 }
 
-Tarhan2013PFMBLProvisioning::~Tarhan2013PFMBLProvisioning() {
+template<specIndex_t numSlots>
+Tarhan2013PFMBLProvisioning<numSlots>::~Tarhan2013PFMBLProvisioning() {
 }
 
-Provisioning Tarhan2013PFMBLProvisioning::operator ()(const NetworkGraph& g,
-		const NetworkState& s, const NetworkGraph::DijkstraData &data, const Request& r) {
+template<specIndex_t numSlots>
+Provisioning Tarhan2013PFMBLProvisioning<numSlots>::operator ()(const NetworkGraph& g,
+		const NetworkState<numSlots>& s, const NetworkGraph::DijkstraData &data, const Request& r) {
 	Provisioning result;
 	result.bandwidth=r.bandwidth;
 	result.priSpecEnd=0;
@@ -76,11 +82,13 @@ Provisioning Tarhan2013PFMBLProvisioning::operator ()(const NetworkGraph& g,
 	NetworkGraph::YenKShortestSearch y(g,r.source,r.dest,data);
 	{
 		const std::vector<NetworkGraph::Path> &priPaths=y.getPaths(k_pri);
+		typename NetworkState<numSlots>::TrieAvailability priAvail(s,y.getTrie(k_pri));
 		if(priPaths.empty()) {
 			result.state=Provisioning::BLOCK_PRI_NOPATH;
 			return result;
 		}
-		for(auto const &p:priPaths) {
+		for(size_t pi=0; pi<priPaths.size(); ++pi) {
+			const NetworkGraph::Path &p=priPaths[pi];
 			distance_t len=0;
 			for(auto const &e:p) len+=data.weights[e.idx];
 
@@ -91,18 +99,9 @@ Provisioning Tarhan2013PFMBLProvisioning::operator ()(const NetworkGraph& g,
 			}
 			specIndex_t neededSpec=calcNumSlots(r.bandwidth,result.priMod);
 
-			const NetworkState::spectrum_bits spec=s.priAvailability(p);
-
-			specIndex_t count=0;
-			for(specIndex_t i=0; i<NUM_SLOTS; ++i) {
-				if(spec[i]) count=0;
-				else if(++count==neededSpec) {
-					result.priSpecBegin=i-count+1;
-					result.priSpecEnd=i+1;
-					break;
-				}
-			}
-			if(result.priSpecEnd) {
+			//first-fit over all fibers
+			if(priAvail.firstFit(pi,neededSpec,result.priFiber,result.priSpecBegin)) {
+				result.priSpecEnd=result.priSpecBegin+neededSpec;
 				result.priPath=p;
 				break;
 			}
@@ -120,6 +119,7 @@ Provisioning Tarhan2013PFMBLProvisioning::operator ()(const NetworkGraph& g,
 	for(auto const &e:result.priPath) data.weights[e.idx]=std::numeric_limits<distance_t>::max();
 	const std::vector<NetworkGraph::Path> &bkpPaths=y.getPaths(k_bkp);
 	for(auto const &e:result.priPath) data.weights[e.idx]=g.link_lengths[e.idx];
+	protection.setPrimary(s,result.priPath);
 	if(bkpPaths.empty()) {
 		result.state=Provisioning::BLOCK_SEC_NOPATH;
 		return result;
@@ -132,24 +132,27 @@ Provisioning Tarhan2013PFMBLProvisioning::operator ()(const NetworkGraph& g,
 		if(mod==MOD_NONE) break;
 		specIndex_t neededSpec=calcNumSlots(r.bandwidth,mod);
 
-		const NetworkState::spectrum_bits spec=s.bkpAvailability(result.priPath,p);
-
-		specIndex_t count=0;
-		for(specIndex_t i=NUM_SLOTS-1; ; --i) {
-			if(spec[i]) {
-				count=0;
-			} else if(++count>=neededSpec) {
-				unsigned int cost=c1?(NUM_SLOTS-i)*c1+neededSpec*1000u:(NUM_SLOTS-i);
-				if(cost<bestCost) {
-					bestCost=cost;
-					bestPath=&p;
-					result.bkpSpecBegin=i;
-					result.bkpSpecEnd=i+neededSpec;
-					result.bkpMod=mod;
+		for(fiberIndex_t f=0; f<s.getNumFibers(); ++f) {
+			const typename NetworkState<numSlots>::spectrum_bits spec=protection.bkpAvailability(p,f);
+
+			specIndex_t count=0;
+			for(specIndex_t i=numSlots-1; ; --i) {
+				if(spec[i]) {
+					count=0;
+				} else if(++count>=neededSpec) {
+					unsigned int cost=c1?(numSlots-i)*c1+neededSpec*1000u:(numSlots-i);
+					if(cost<bestCost) {
+						bestCost=cost;
+						bestPath=&p;
+						result.bkpFiber=f;
+						result.bkpSpecBegin=i;
+						result.bkpSpecEnd=i+neededSpec;
+						result.bkpMod=mod;
+					}
+					break;
 				}
-				break;
+				if(!i) break;
 			}
-			if(!i) break;
 		}
 	}
 	if(bestPath) {
@@ -161,10 +164,15 @@ Provisioning Tarhan2013PFMBLProvisioning::operator ()(const NetworkGraph& g,
 	return result;
 }
 
-std::ostream& Tarhan2013PFMBLProvisioning::print(std::ostream& o) const {
-	return printFormatted(o,helpstr,pdesc);
+template<specIndex_t numSlots>
+std::ostream& Tarhan2013PFMBLProvisioning<numSlots>::print(std::ostream& o) const {
+	return this->printFormatted(o,helpstr,pdesc);
 }
 
-ProvisioningScheme* Tarhan2013PFMBLProvisioning::clone() {
+template<specIndex_t numSlots>
+ProvisioningScheme<numSlots>* Tarhan2013PFMBLProvisioning<numSlots>::clone() {
 	return new Tarhan2013PFMBLProvisioning(*this);
 }
+
+#define INSTANTIATE_TARHAN2013PFMBLPROVISIONING(n) template class Tarhan2013PFMBLProvisioning<n>;
+FOR_EACH_NUM_SLOTS(INSTANTIATE_TARHAN2013PFMBLPROVISIONING)
@@ -29,19 +29,21 @@
 /**
  * \brief Implementation of the PF-MBL heuristic.
  */
-class Tarhan2013PFMBLProvisioning: public ProvisioningScheme {
+template<specIndex_t numSlots>
+class Tarhan2013PFMBLProvisioning: public ProvisioningScheme<numSlots> {
 public:
-	Tarhan2013PFMBLProvisioning(const ParameterSet &p);
+	Tarhan2013PFMBLProvisioning(const ProvisioningSchemeBase::ParameterSet &p);
 	virtual ~Tarhan2013PFMBLProvisioning();
-	virtual ProvisioningScheme *clone();
-	virtual Provisioning operator()(const NetworkGraph &g, const NetworkState &s, const NetworkGraph::DijkstraData &data, const Request &r);
+	virtual ProvisioningScheme<numSlots> *clone();
+	virtual Provisioning operator()(const NetworkGraph &g, const NetworkState<numSlots> &s, const NetworkGraph::DijkstraData &data, const Request &r);
 protected:
 	virtual std::ostream& print(std::ostream &o) const;
 private:
 	static const char *const helpstr;
-	static const paramDesc_t pdesc[];
+	static const ProvisioningSchemeBase::paramDesc_t pdesc[];
 	unsigned int k_pri, k_bkp;
 	unsigned int c1;
+	typename NetworkState<numSlots>::ProtectionRows protection;
 };
 
 #endif /* TARHAN2013PFMBLPROVISIONING_H_ */